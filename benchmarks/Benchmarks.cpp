@@ -1,3 +1,5 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+
 TEST_CASE ("Boot performance")
 {
     BENCHMARK_ADVANCED ("Processor constructor")
@@ -30,3 +32,149 @@ TEST_CASE ("Boot performance")
         });
     };
 }
+
+TEST_CASE ("Multi-core rendering")
+{
+    juce::TemporaryFile tempFile (".wav");
+    {
+        juce::AudioBuffer<float> audio (1, 48000);
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            audio.setSample (0, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * 220.0f * (float) i / 48000.0f));
+
+        juce::WavAudioFormat wav;
+        auto stream = std::make_unique<juce::FileOutputStream> (tempFile.getFile());
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), 48000.0, 1, 16, {}, 0));
+        REQUIRE (writer != nullptr);
+        stream.release(); // Owned by the writer now
+        writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    constexpr int numParticles = 64;
+    constexpr int blockSize = 256;
+    const int availableWorkers = juce::jmax (0, juce::SystemStats::getNumCpus() - 1);
+
+    // 1, 2, 4, 8 threads (the audio thread plus workers), as far as this machine goes
+    for (int numWorkers : { 0, 1, 3, 7 })
+    {
+        if (numWorkers > availableWorkers)
+            break;
+
+        PluginProcessor plugin;
+        plugin.loadAudioFile (tempFile.getFile());
+        plugin.waitForAudioFile();
+        plugin.setMaxParticles (numParticles);
+        plugin.setMaxRenderWorkers (numWorkers);
+        plugin.getAPVTS().getParameter ("multiCore")->setValueNotifyingHost (1.0f);
+        plugin.prepareToPlay (48000.0, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+        for (int note = 0; note < numParticles; ++note)
+            midi.addEvent (juce::MidiMessage::noteOn (1, 32 + note, 0.8f), 0);
+
+        // Let the held notes build up their grains before measuring
+        for (int block = 0; block < 50; ++block)
+        {
+            plugin.processBlock (buffer, midi);
+            midi.clear();
+        }
+
+        BENCHMARK ("Process block, " + std::to_string (numWorkers + 1) + " threads")
+        {
+            plugin.processBlock (buffer, midi);
+            return buffer.getSample (0, 0);
+        };
+
+        plugin.releaseResources();
+    }
+}
+
+TEST_CASE ("Orbit integrators")
+{
+    constexpr int numBodies = 256;
+    constexpr float strength = 100000.0f;
+    const juce::Point<float> centre { 200.0f, 200.0f };
+    const ParticlePhysics::Mass mass { centre, strength };
+
+    const auto energy = [&] (const ParticlePhysics& physics, size_t i) {
+        const double dx = physics.x[i] - centre.x;
+        const double dy = physics.y[i] - centre.y;
+        return 0.5 * (physics.vx[i] * physics.vx[i] + physics.vy[i] * physics.vy[i]) - strength / std::sqrt (dx * dx + dy * dy);
+    };
+
+    const std::pair<ParticlePhysics::Integrator, const char*> integrators[] = {
+        { ParticlePhysics::Integrator::Euler, "Euler" },
+        { ParticlePhysics::Integrator::VelocityVerlet, "Velocity Verlet" },
+        { ParticlePhysics::Integrator::RK4, "RK4" }
+    };
+
+    for (const auto& [integrator, name] : integrators)
+    {
+        ParticlePhysics physics (numBodies);
+        std::vector<std::unique_ptr<Particle>> particles;
+
+        // A ring of circular orbits, so the energy of each body should stay put
+        for (int i = 0; i < numBodies; ++i)
+        {
+            const float radius = 20.0f + 0.6f * static_cast<float> (i);
+            const float angle = 2.4f * static_cast<float> (i);
+            const float speed = std::sqrt (strength / radius);
+
+            particles.push_back (std::make_unique<Particle> (centre + juce::Point<float> (std::cos (angle), std::sin (angle)) * radius,
+                                                             juce::Point<float> (-std::sin (angle), std::cos (angle)) * speed,
+                                                             juce::Rectangle<float> (0.0f, 0.0f, 400.0f, 400.0f),
+                                                             60, 0.01f, 0.7f, 0.7f, 0.5f));
+            physics.addBody (*particles.back());
+        }
+
+        std::vector<double> initialEnergy;
+        for (size_t i = 0; i < numBodies; ++i)
+            initialEnergy.push_back (energy (physics, i));
+
+        // Energy drift after 20 s at a coarse 20 ms step, to set against the cost per step
+        for (int step = 0; step < 1000; ++step)
+            physics.step (0.02f, integrator, &mass, 1);
+
+        double drift = 0.0;
+        for (size_t i = 0; i < numBodies; ++i)
+            drift = std::max (drift, std::abs ((energy (physics, i) - initialEnergy[i]) / initialEnergy[i]));
+
+        WARN (name << ": max relative energy drift " << drift);
+
+        // One step at the default control interval
+        BENCHMARK (std::string (name) + " step, " + std::to_string (numBodies) + " bodies")
+        {
+            physics.step (32.0f / 48000.0f, integrator, &mass, 1);
+            return physics.x[0];
+        };
+    }
+}
+
+TEST_CASE ("Mutual gravity")
+{
+    constexpr int numBodies = 512;
+
+    juce::Random random (1);
+    std::vector<float> x, y, mass;
+    for (int i = 0; i < numBodies; ++i)
+    {
+        x.push_back (random.nextFloat() * 400.0f);
+        y.push_back (random.nextFloat() * 400.0f);
+        mass.push_back (random.nextFloat());
+    }
+
+    std::vector<float> ax (numBodies), ay (numBodies);
+    BarnesHutTree tree;
+    tree.reserve (numBodies);
+
+    // An opening angle of 0 visits every pair, the naive O(n^2) sum
+    for (float openingAngle : { 0.0f, 0.5f, 1.0f })
+    {
+        BENCHMARK ("Build and sum, " + std::to_string (numBodies) + " bodies, opening angle " + juce::String (openingAngle, 1).toStdString())
+        {
+            tree.build (x.data(), y.data(), mass.data(), numBodies);
+            tree.addAccelerations (x.data(), y.data(), mass.data(), ax.data(), ay.data(), numBodies, 1.0f, openingAngle);
+            return ax[0];
+        };
+    }
+}
@@ -0,0 +1,201 @@
+#include "BarnesHutTree.h"
+#include <array>
+
+//==============================================================================
+void BarnesHutTree::reserve (int maxBodies)
+{
+    // Enough for a typical spread; denser clusters fall back to shared leaves
+    nodes.resize (static_cast<size_t>(8 * juce::jmax (1, maxBodies) + 1));
+    bodyLeaf.resize (static_cast<size_t>(juce::jmax (1, maxBodies)), -1);
+}
+
+void BarnesHutTree::build (const float* x, const float* y, const float* mass, int count)
+{
+    jassert (count <= static_cast<int>(bodyLeaf.size()));
+    numNodes = 0;
+
+    float minX = std::numeric_limits<float>::max(), minY = minX;
+    float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (mass[i] <= 0.0f)
+            continue;
+
+        minX = juce::jmin (minX, x[i]);
+        maxX = juce::jmax (maxX, x[i]);
+        minY = juce::jmin (minY, y[i]);
+        maxY = juce::jmax (maxY, y[i]);
+    }
+
+    if (minX > maxX)
+    {
+        std::fill (bodyLeaf.begin(), bodyLeaf.begin() + count, -1);
+        return;
+    }
+
+    // A square root slightly bigger than the bodies' extent, so every body falls strictly inside
+    auto& root = nodes[0];
+    root = {};
+    root.centreX = 0.5f * (minX + maxX);
+    root.centreY = 0.5f * (minY + maxY);
+    root.halfSize = 0.5f * juce::jmax (maxX - minX, maxY - minY) * 1.001f + 1.0e-3f;
+    numNodes = 1;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (mass[i] > 0.0f)
+            insert (i, x[i], y[i], mass[i]);
+        else
+            bodyLeaf[static_cast<size_t>(i)] = -1;
+    }
+}
+
+void BarnesHutTree::accumulate (Node& node, float x, float y, float mass)
+{
+    node.mass += mass;
+    node.massX += mass * x;
+    node.massY += mass * y;
+}
+
+void BarnesHutTree::insert (int body, float x, float y, float mass)
+{
+    int index = 0;
+
+    for (int depth = 0;; ++depth)
+    {
+        auto& node = nodes[static_cast<size_t>(index)];
+
+        if (node.firstChild >= 0)
+        {
+            accumulate (node, x, y, mass);
+            index = node.firstChild + (x >= node.centreX ? 1 : 0) + (y >= node.centreY ? 2 : 0);
+            continue;
+        }
+
+        if (node.body == empty)
+        {
+            accumulate (node, x, y, mass);
+            node.body = body;
+            bodyLeaf[static_cast<size_t>(body)] = index;
+            return;
+        }
+
+        const bool canSplit = node.body != shared
+                           && depth < maxDepth
+                           && numNodes + 4 <= static_cast<int>(nodes.size());
+
+        if (! canSplit)
+        {
+            accumulate (node, x, y, mass);
+            node.body = shared;
+            bodyLeaf[static_cast<size_t>(body)] = index;
+            return;
+        }
+
+        // Split the leaf, moving its body down into the matching child
+        const int firstChild = numNodes;
+        numNodes += 4;
+        const float quarter = 0.5f * node.halfSize;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            auto& child = nodes[static_cast<size_t>(firstChild + c)];
+            child = {};
+            child.centreX = node.centreX + ((c & 1) != 0 ? quarter : -quarter);
+            child.centreY = node.centreY + ((c & 2) != 0 ? quarter : -quarter);
+            child.halfSize = quarter;
+        }
+
+        const int existing = node.body;
+        const float existingX = node.massX / node.mass;
+        const float existingY = node.massY / node.mass;
+        const int existingChild = firstChild + (existingX >= node.centreX ? 1 : 0) + (existingY >= node.centreY ? 2 : 0);
+
+        auto& moved = nodes[static_cast<size_t>(existingChild)];
+        accumulate (moved, existingX, existingY, node.mass);
+        moved.body = existing;
+        bodyLeaf[static_cast<size_t>(existing)] = existingChild;
+
+        node.firstChild = firstChild;
+        node.body = empty;
+
+        // Loop round again: the node is internal now, so the new body is accumulated and sent down
+        --depth;
+    }
+}
+
+void BarnesHutTree::addAccelerations (const float* x, const float* y, const float* bodyMass,
+                                      float* outX, float* outY, int count, float strength, float openingAngle) const
+{
+    if (numNodes == 0)
+        return;
+
+    const float openingAngleSquared = openingAngle * openingAngle;
+    std::array<int, 4 * maxDepth + 4> stack;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const float px = x[i];
+        const float py = y[i];
+        const int ownLeaf = bodyLeaf[static_cast<size_t>(i)];
+        float ax = 0.0f, ay = 0.0f;
+
+        int stackSize = 0;
+        stack[static_cast<size_t>(stackSize++)] = 0;
+
+        while (stackSize > 0)
+        {
+            const int index = stack[static_cast<size_t>(--stackSize)];
+            const auto& node = nodes[static_cast<size_t>(index)];
+
+            float mass = node.mass;
+            float massX = node.massX;
+            float massY = node.massY;
+
+            if (node.firstChild >= 0)
+            {
+                const float comX = massX / mass;
+                const float comY = massY / mass;
+                const float distanceSquared = (comX - px) * (comX - px) + (comY - py) * (comY - py);
+                const float size = 2.0f * node.halfSize;
+
+                const bool containsBody = std::abs (px - node.centreX) <= node.halfSize
+                                       && std::abs (py - node.centreY) <= node.halfSize;
+
+                if (containsBody || size * size >= openingAngleSquared * distanceSquared)
+                {
+                    for (int c = 0; c < 4; ++c)
+                        if (nodes[static_cast<size_t>(node.firstChild + c)].mass > 0.0f)
+                            stack[static_cast<size_t>(stackSize++)] = node.firstChild + c;
+
+                    continue;
+                }
+            }
+            else if (index == ownLeaf)
+            {
+                // Only the other bodies sharing this leaf pull
+                if (node.body != shared)
+                    continue;
+
+                mass -= bodyMass[i];
+                massX -= bodyMass[i] * px;
+                massY -= bodyMass[i] * py;
+
+                if (mass <= 1.0e-6f)
+                    continue;
+            }
+
+            const float dx = massX / mass - px;
+            const float dy = massY / mass - py;
+            const float distanceSquared = dx * dx + dy * dy + softeningSquared;
+            const float inverseDistance = 1.0f / std::sqrt (distanceSquared);
+            const float scale = mass * inverseDistance * inverseDistance * inverseDistance;
+            ax += dx * scale;
+            ay += dy * scale;
+        }
+
+        outX[i] += strength * ax;
+        outY[i] += strength * ay;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+//==============================================================================
+// Quadtree over a set of bodies for approximate mutual gravity (Barnes-Hut): a
+// node far enough away, relative to its size, pulls as one body at its centre of
+// mass, so summing the pull on every body costs O(n log n) instead of O(n^2).
+//
+// Nodes come from a pool sized by reserve(), so building never allocates. If the
+// pool runs out, or bodies sit too close to split apart, they share a leaf.
+class BarnesHutTree
+{
+public:
+    // Not real-time safe
+    void reserve (int maxBodies);
+
+    // Rebuilds the tree from scratch. Bodies with no mass are left out (but still feel the pull).
+    void build (const float* x, const float* y, const float* mass, int count);
+
+    // Adds strength * sum of m * d / (|d|^2 + softening)^(3/2) over the other bodies to
+    // outX/outY, for the same bodies the tree was built from. An openingAngle of 0 opens
+    // every node, giving the exact pairwise sum.
+    void addAccelerations (const float* x, const float* y, const float* mass,
+                           float* outX, float* outY, int count, float strength, float openingAngle) const;
+
+    int getNumNodes() const { return numNodes; }
+
+    // Keeps close encounters from flinging bodies apart (5 units, like the mass point cutoff)
+    static constexpr float softeningSquared = 5.0f * 5.0f;
+    static constexpr int maxDepth = 20;
+
+private:
+    struct Node
+    {
+        float centreX = 0.0f, centreY = 0.0f, halfSize = 0.0f;
+        float mass = 0.0f, massX = 0.0f, massY = 0.0f;   // Total mass and mass-weighted position
+        int firstChild = -1;                              // Four consecutive children, or -1 for a leaf
+        int body = empty;                                 // The leaf's body, or empty / shared
+    };
+
+    static constexpr int empty = -1;
+    static constexpr int shared = -2;
+
+    std::vector<Node> nodes;
+    int numNodes = 0;
+    std::vector<int> bodyLeaf;   // Leaf holding each body, or -1 if it was left out
+
+    void insert (int body, float x, float y, float mass);
+    static void accumulate (Node& node, float x, float y, float mass);
+};
@@ -23,7 +23,7 @@ Canvas::~Canvas()
 }
 
 //==============================================================================
-juce::OwnedArray<Particle>* Canvas::getParticles()
+std::vector<Particle*>* Canvas::getParticles()
 {
     return audioProcessor.getParticles();
 }
@@ -173,6 +173,22 @@ void Canvas::drawGravityWaves (juce::Graphics& g)
     // Draw interference patterns when multiple mass points exist
     if (massPoints.size() >= 2)
     {
+        // Same field the physics can run on, rebuilt only when the masses or size change
+        if (gravityFieldVersion != audioProcessor.getMassConfigurationVersion()
+            || gravityField.getBounds() != getLocalBounds().toFloat())
+        {
+            std::array<ParticlePhysics::Mass, GravityField::maxMasses> unitMasses;
+            const int numMasses = juce::jmin (static_cast<int>(massPointsData.size()), GravityField::maxMasses);
+            
+            for (int i = 0; i < numMasses; ++i)
+                unitMasses[static_cast<size_t>(i)] = { massPointsData[static_cast<size_t>(i)].position,
+                                                       massPointsData[static_cast<size_t>(i)].massMultiplier };
+            
+            gravityFieldVersion = audioProcessor.getMassConfigurationVersion();
+            gravityField.setMasses (unitMasses.data(), numMasses, getLocalBounds().toFloat());
+            gravityField.build();
+        }
+        
         int gridSize = 20;
         float cellWidth = getWidth() / (float)gridSize;
         float cellHeight = getHeight() / (float)gridSize;
@@ -186,31 +202,16 @@ void Canvas::drawGravityWaves (juce::Graphics& g)
                 juce::Point<float> gridPoint (x * cellWidth + cellWidth / 2, 
                                               y * cellHeight + cellHeight / 2);
                 
-                float totalPotential = 0.0f;
-                juce::Point<float> totalForce (0.0f, 0.0f);
-                
-                for (auto* mass : massPoints)
-                {
-                    juce::Point<float> massCenter (mass->getBounds().getCentreX(), 
-                                                   mass->getBounds().getCentreY());
-                    
-                    float distance = gridPoint.getDistanceFrom (massCenter);
-                    if (distance > 1.0f)
-                    {
-                        float potential = mass->getMassMultiplier() / distance;
-                        totalPotential += potential;
-                        
-                        juce::Point<float> direction = (massCenter - gridPoint) / distance;
-                        totalForce += direction * potential;
-                    }
-                }
+                const auto field = gravityField.sample (gridPoint);
+                float totalPotential = field.potential;
+                juce::Point<float> totalForce = field.acceleration;
                 
                 if (totalPotential > 0.01f)
                 {
                     float forceMagnitude = totalForce.getDistanceFromOrigin();
                     if (forceMagnitude > 0.0f)
                     {
-                        float lineLength = juce::jmin (forceMagnitude * 10.0f, 15.0f);
+                        float lineLength = juce::jmin (forceMagnitude * 1000.0f, 15.0f);
                         juce::Point<float> normalizedForce = totalForce / forceMagnitude;
                         juce::Point<float> endPoint = gridPoint + normalizedForce * lineLength;
                         
@@ -464,15 +465,10 @@ void Canvas::spawnParticle()
         return;
     }
     
-    auto* processorParticles = audioProcessor.getParticles();
+    // The processor recycles its oldest particle when at the limit
     auto& particlesLock = audioProcessor.getParticlesLock();
     const juce::ScopedLock lock (particlesLock);
     
-    if (processorParticles->size() >= maxParticles)
-    {
-        processorParticles->remove (0);
-    }
-    
     // Round-robin through spawn points
     auto* spawn = spawnPoints[nextSpawnPointIndex];
     nextSpawnPointIndex = (nextSpawnPointIndex + 1) % spawnPoints.size();
@@ -494,15 +490,10 @@ void Canvas::spawnParticleFromMidi (int midiNote, float midiVelocity)
         return;
     }
     
-    auto* processorParticles = audioProcessor.getParticles();
+    // The processor recycles its oldest particle when at the limit
     auto& particlesLock = audioProcessor.getParticlesLock();
     const juce::ScopedLock lock (particlesLock);
     
-    if (processorParticles->size() >= maxParticles)
-    {
-        processorParticles->remove (0);
-    }
-    
     // Round-robin through spawn points
     auto* spawn = spawnPoints[nextSpawnPointIndex];
     nextSpawnPointIndex = (nextSpawnPointIndex + 1) % spawnPoints.size();
@@ -561,13 +552,12 @@ void Canvas::timerCallback()
 
 void Canvas::drawParticles (juce::Graphics& g)
 {
-    auto* processorParticles = audioProcessor.getParticles();
-    auto& particlesLock = audioProcessor.getParticlesLock();
-    const juce::ScopedLock lock (particlesLock);
+    // Drawn from the latest snapshot, so painting never blocks the audio thread
+    const auto& snapshot = audioProcessor.readParticleSnapshot();
     
-    for (auto* particle : *processorParticles)
+    for (int i = 0; i < snapshot.numBodies; ++i)
     {
-        particle->draw (g);
+        Particle::draw (g, snapshot, snapshot.bodies[static_cast<size_t>(i)]);
     }
 }
 
@@ -584,6 +574,8 @@ void Canvas::drawWaveform (juce::Graphics& g)
     const float maxOpacity = 1.0f;
     const float influenceRadius = 30.0f;
     
+    const auto& snapshot = audioProcessor.readParticleSnapshot();
+    
     for (int y = 0; y < canvasHeight; y += 4)
     {
         // Map y to sample (bottom = start, top = end)
@@ -610,23 +602,17 @@ void Canvas::drawWaveform (juce::Graphics& g)
         float maxRightInfluence = 0.0f;
         float maxCenterInfluence = 0.0f;
         
-        auto* processorParticles = audioProcessor.getParticles();
-        auto& particlesLock = audioProcessor.getParticlesLock();
-        const juce::ScopedLock lock (particlesLock);
-        
-        for (auto* particle : *processorParticles)
+        for (int i = 0; i < snapshot.numBodies; ++i)
         {
-            if (particle == nullptr)
-                continue;
-                
-            auto pos = particle->getPosition();
+            const auto& body = snapshot.bodies[static_cast<size_t>(i)];
+            auto pos = body.position;
             float distance = std::abs(pos.y - y);
             
             if (distance < influenceRadius)
             {
                 float influence = 1.0f - (distance / influenceRadius);
                 influence = influence * influence;
-                influence *= particle->getADSRAmplitude();
+                influence *= body.adsrAmplitude;
                 
                 float normalizedX = pos.x / canvasWidth;
                 
@@ -667,9 +653,10 @@ void Canvas::drawWaveform (juce::Graphics& g)
     }
 }
 
-void Canvas::setAudioBuffer (const juce::AudioBuffer<float>* buffer)
+void Canvas::setSample (std::shared_ptr<const LoadedSample> newSample)
 {
-    audioBuffer = buffer;
+    sample = std::move (newSample);
+    audioBuffer = sample != nullptr ? &sample->audio : nullptr;
     repaint();
 }
 
@@ -6,6 +6,8 @@
 #include "SpawnPoint.h"
 #include "MassPoint.h"
 #include "Particle.h"
+#include "GravityField.h"
+#include "SampleLoader.h"
 #include "CustomPopupMenuLookAndFeel.h"
 
 class PluginProcessor;
@@ -45,13 +47,15 @@ public:
     
     std::function<void(const juce::File&)> onAudioFileLoaded;
     
-    void setAudioBuffer (const juce::AudioBuffer<float>* buffer);
+    // Shared with the processor, which may move on to another file while this one is shown
+    void setSample (std::shared_ptr<const LoadedSample> newSample);
+    const std::shared_ptr<const LoadedSample>& getSample() const { return sample; }
     void setParticleLifespan (float lifespanSeconds) { particleLifespan = lifespanSeconds; }
     void setBounceMode (bool enabled);
     void setCustomTypeface (juce::Typeface::Ptr typeface) { customTypeface = typeface; }
     
     // Deprecated - particles live in processor. Kept for backward compatibility.
-    juce::OwnedArray<Particle>* getParticles();
+    std::vector<Particle*>* getParticles();
     juce::CriticalSection& getParticlesLock();
 
 private:
@@ -60,17 +64,19 @@ private:
     bool bounceMode = false;
     int maxSpawnPoints = 8;
     int maxMassPoints = 4;
-    int maxParticles = 8;
     juce::OwnedArray<SpawnPoint> spawnPoints;
     juce::OwnedArray<MassPoint> massPoints;
     
     bool showGravityWaves = true;
+    GravityField gravityField;
+    uint32_t gravityFieldVersion = 0;
     int nextSpawnPointIndex = 0;
     float gravityStrength = 50000.0f;
     float particleLifespan = 30.0f;
     
     bool isDraggingFile = false;
-    const juce::AudioBuffer<float>* audioBuffer = nullptr;
+    std::shared_ptr<const LoadedSample> sample;
+    const juce::AudioBuffer<float>* audioBuffer = nullptr;   // sample's audio, or nullptr
     
     SpawnPoint* draggedArrowSpawnPoint = nullptr;
     static constexpr float minArrowLength = 20.0f;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+// A vector whose storage lives inline, for per-particle lists that must never touch
+// the heap. Holds at most Capacity default-constructible elements; erasing shifts
+// the rest down like std::vector, so iterators are plain pointers.
+template <typename T, size_t Capacity>
+class FixedCapacityVector
+{
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_t capacity() { return Capacity; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+
+    iterator begin() { return items.data(); }
+    iterator end() { return items.data() + count; }
+    const_iterator begin() const { return items.data(); }
+    const_iterator end() const { return items.data() + count; }
+
+    T& operator[] (size_t index) { jassert (index < count); return items[index]; }
+    const T& operator[] (size_t index) const { jassert (index < count); return items[index]; }
+    T& back() { jassert (count > 0); return items[count - 1]; }
+    const T& back() const { jassert (count > 0); return items[count - 1]; }
+
+    void clear() { count = 0; }
+
+    // The caller makes room first; a push onto a full vector is dropped
+    void push_back (const T& item)
+    {
+        jassert (! full());
+
+        if (count < Capacity)
+            items[count++] = item;
+    }
+
+    iterator erase (iterator position) { return erase (position, position + 1); }
+
+    iterator erase (iterator first, iterator last)
+    {
+        const auto newEnd = std::move (last, end(), first);
+        count = static_cast<size_t>(newEnd - begin());
+        return first;
+    }
+
+private:
+    std::array<T, Capacity> items {};
+    size_t count = 0;
+};
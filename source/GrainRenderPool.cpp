@@ -0,0 +1,287 @@
+#include "GrainRenderPool.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    // Posting never takes a lock, so the audio thread can use it to wake workers
+    class Semaphore
+    {
+    public:
+       #if JUCE_MAC || JUCE_IOS
+        Semaphore() : handle (dispatch_semaphore_create (0)) {}
+        ~Semaphore() { dispatch_release (handle); }
+        void signal() { dispatch_semaphore_signal (handle); }
+        void wait() { dispatch_semaphore_wait (handle, DISPATCH_TIME_FOREVER); }
+
+    private:
+        dispatch_semaphore_t handle;
+       #elif JUCE_WINDOWS
+        Semaphore() : handle (CreateSemaphoreW (nullptr, 0, LONG_MAX, nullptr)) {}
+        ~Semaphore() { CloseHandle (handle); }
+        void signal() { ReleaseSemaphore (handle, 1, nullptr); }
+        void wait() { WaitForSingleObject (handle, INFINITE); }
+
+    private:
+        HANDLE handle;
+       #else
+        Semaphore() { sem_init (&handle, 0, 0); }
+        ~Semaphore() { sem_destroy (&handle); }
+        void signal() { sem_post (&handle); }
+        void wait() { while (sem_wait (&handle) != 0 && errno == EINTR) {} }
+
+    private:
+        sem_t handle;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (Semaphore)
+    };
+
+    inline void spinPause()
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    // How long an idle worker keeps polling before it parks on its semaphore
+    constexpr double spinSeconds = 0.0002;
+}
+
+//==============================================================================
+class GrainRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker (GrainRenderPool& ownerPool, int index, int busSize)
+        : juce::Thread ("Orbit grain renderer " + juce::String (index)),
+          bus (2, busSize),
+          pool (ownerPool),
+          threadIndex (index)
+    {
+    }
+
+    ~Worker() override
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        semaphore.signal();
+        stopThread (1000);
+    }
+
+    // Called by the audio thread after publishing a job
+    void wake()
+    {
+        if (parked.exchange (false))
+            semaphore.signal();
+    }
+
+    void run() override
+    {
+        auto seen = pool.generation.load (std::memory_order_acquire);
+
+        while (! threadShouldExit())
+        {
+            if (pool.generation.load (std::memory_order_acquire) == seen && ! waitForJob (seen))
+                continue;
+
+            seen = pool.generation.load (std::memory_order_acquire);
+
+            if (! pool.tryJoin())
+                continue;
+
+            usedBus = true;
+            const int numSamples = pool.currentNumSamples;
+            auto* left = bus.getWritePointer (0);
+            auto* right = pool.currentStereo ? bus.getWritePointer (1) : nullptr;
+
+            juce::FloatVectorOperations::clear (left, numSamples);
+            if (right != nullptr)
+                juce::FloatVectorOperations::clear (right, numSamples);
+
+            pool.renderItems (threadIndex, left, right);
+            pool.joinState.fetch_sub (1, std::memory_order_release);
+        }
+    }
+
+    juce::AudioBuffer<float> bus;
+    bool usedBus = false;   // Set inside a job, cleared by the audio thread after summing
+
+private:
+    // Polls for a new generation for a short while, then parks. Returns true if one arrived.
+    bool waitForJob (uint32_t seen)
+    {
+        const auto spinUntil = juce::Time::getMillisecondCounterHiRes() + spinSeconds * 1000.0;
+
+        while (juce::Time::getMillisecondCounterHiRes() < spinUntil)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                if (pool.generation.load (std::memory_order_acquire) != seen)
+                    return true;
+
+                spinPause();
+            }
+        }
+
+        // Publish that we're parking before the final check, so a job posted in
+        // between either gets seen here or wakes the semaphore
+        parked.store (true);
+
+        if (pool.generation.load() != seen || threadShouldExit())
+        {
+            // If the audio thread already claimed the wake-up, consume its post
+            if (! parked.exchange (false))
+                semaphore.wait();
+
+            return true;
+        }
+
+        semaphore.wait();
+        return pool.generation.load (std::memory_order_acquire) != seen;
+    }
+
+    GrainRenderPool& pool;
+    const int threadIndex;
+    Semaphore semaphore;
+    std::atomic<bool> parked { false };
+};
+
+//==============================================================================
+GrainRenderPool::GrainRenderPool() = default;
+
+GrainRenderPool::~GrainRenderPool()
+{
+    release();
+}
+
+void GrainRenderPool::prepare (int numWorkers, int newMaxBlockSize, double sampleRate)
+{
+    release();
+
+    maxBlockSize = newMaxBlockSize;
+    ranges = std::make_unique<Range[]> (static_cast<size_t>(numWorkers + 1));
+    joinState.store (closedFlag);
+
+    const auto realtimeOptions = juce::Thread::RealtimeOptions{}
+                                     .withApproximateAudioProcessingTime (maxBlockSize, sampleRate);
+
+    for (int i = 1; i <= numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker> (*this, i, maxBlockSize);
+
+        // Real-time scheduling may need privileges the host doesn't have
+        if (! worker->startRealtimeThread (realtimeOptions))
+            worker->startThread (juce::Thread::Priority::highest);
+
+        workers.push_back (std::move (worker));
+    }
+}
+
+void GrainRenderPool::release()
+{
+    for (auto& worker : workers)
+        worker->stop();
+
+    workers.clear();
+}
+
+void GrainRenderPool::run (Job& job, int numItems, float* left, float* right, int numSamples)
+{
+    const int numThreads = getNumWorkers() + 1;
+
+    if (numThreads == 1 || numItems < minItemsForParallel || numSamples > maxBlockSize)
+    {
+        for (int item = 0; item < numItems; ++item)
+            job.renderItem (item, 0, left, right, numSamples);
+
+        return;
+    }
+
+    // No worker is inside a job here (joinState is closed with a count of zero)
+    currentJob = &job;
+    currentNumSamples = numSamples;
+    currentStereo = right != nullptr;
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        ranges[i].next.store (numItems * i / numThreads, std::memory_order_relaxed);
+        ranges[i].end = numItems * (i + 1) / numThreads;
+    }
+
+    joinState.store (0, std::memory_order_release);
+    generation.fetch_add (1);
+
+    for (auto& worker : workers)
+        worker->wake();
+
+    renderItems (0, left, right);
+
+    // Every item is claimed. Stop late workers joining, then wait out any still mid-item.
+    joinState.fetch_or (closedFlag, std::memory_order_acq_rel);
+
+    while ((joinState.load (std::memory_order_acquire) & ~closedFlag) != 0)
+        spinPause();
+
+    for (auto& worker : workers)
+    {
+        if (! worker->usedBus)
+            continue;
+
+        juce::FloatVectorOperations::add (left, worker->bus.getReadPointer (0), numSamples);
+        if (right != nullptr)
+            juce::FloatVectorOperations::add (right, worker->bus.getReadPointer (1), numSamples);
+
+        worker->usedBus = false;
+    }
+}
+
+bool GrainRenderPool::tryJoin()
+{
+    auto state = joinState.load (std::memory_order_acquire);
+
+    while ((state & closedFlag) == 0)
+        if (joinState.compare_exchange_weak (state, state + 1, std::memory_order_acquire))
+            return true;
+
+    return false;
+}
+
+void GrainRenderPool::renderItems (int threadIndex, float* left, float* right)
+{
+    const int numThreads = getNumWorkers() + 1;
+
+    // Own range first, then steal from the others in turn
+    for (int offset = 0; offset < numThreads; ++offset)
+    {
+        auto& range = ranges[(threadIndex + offset) % numThreads];
+
+        for (int item = range.next.fetch_add (1, std::memory_order_relaxed); item < range.end;
+             item = range.next.fetch_add (1, std::memory_order_relaxed))
+        {
+            currentJob->renderItem (item, threadIndex, left, right, currentNumSamples);
+        }
+    }
+}
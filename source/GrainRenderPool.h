@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Splits a block's grain rendering across a fixed set of real-time worker
+// threads. The audio thread publishes a job through atomics, wakes any parked
+// workers with a semaphore post (never a lock), renders alongside them and then
+// sums each worker's private stereo bus into its own output.
+//
+// Items are dealt out as one contiguous range per thread. A thread that runs out
+// of its own range steals from the others, so a worker that wakes late (or not
+// at all) only costs the audio thread the items it ends up doing itself.
+class GrainRenderPool
+{
+public:
+    struct Job
+    {
+        virtual ~Job() = default;
+
+        // Adds item's output into left/right (right may be nullptr). threadIndex is
+        // 0 for the audio thread and 1..getNumWorkers() for workers, for per-thread scratch.
+        virtual void renderItem (int item, int threadIndex, float* left, float* right, int numSamples) = 0;
+    };
+
+    // Fewer items than this aren't worth waking anyone for
+    static constexpr int minItemsForParallel = 8;
+
+    GrainRenderPool();
+    ~GrainRenderPool();
+
+    // Not real-time safe: stops any running workers, then starts numWorkers new ones
+    void prepare (int numWorkers, int maxBlockSize, double sampleRate);
+    void release();
+
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    // Renders items [0, numItems) into left/right. Falls back to rendering everything
+    // on the calling thread if there are no workers or the workload is small.
+    void run (Job& job, int numItems, float* left, float* right, int numSamples);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    struct alignas(64) Range
+    {
+        std::atomic<int> next { 0 };
+        int end = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::unique_ptr<Range[]> ranges;
+    int maxBlockSize = 0;
+
+    // Written by the audio thread only while no worker can be inside a job
+    Job* currentJob = nullptr;
+    int currentNumSamples = 0;
+    bool currentStereo = true;
+
+    // Bumped once per job; workers watch it to know there's work
+    alignas(64) std::atomic<uint32_t> generation { 0 };
+
+    // Count of workers inside the current job, plus closedFlag once the
+    // audio thread has finished its share and stopped new workers joining
+    alignas(64) std::atomic<uint32_t> joinState { closedFlag };
+    static constexpr uint32_t closedFlag = 0x80000000u;
+
+    bool tryJoin();
+    void renderItems (int threadIndex, float* left, float* right);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainRenderPool)
+};
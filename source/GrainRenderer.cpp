@@ -0,0 +1,266 @@
+#include "GrainRenderer.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+#include "GrainRendererKernels.h"
+
+#if ORBIT_GRAIN_RENDERER_NEON
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    struct ScalarOps
+    {
+        using V = float;
+        static constexpr int width = 1;
+
+        static V load (const float* p) { return *p; }
+        static void store (float* p, V v) { *p = v; }
+        static V set1 (float v) { return v; }
+        static V add (V a, V b) { return a + b; }
+        static V sub (V a, V b) { return a - b; }
+        static V mul (V a, V b) { return a * b; }
+        static V min (V a, V b) { return b < a ? b : a; }
+        static V max (V a, V b) { return a < b ? b : a; }
+        static V flushBelow (V v, float threshold) { return std::abs (v) < threshold ? 0.0f : v; }
+        static bool anyAbove (V a, V b, float threshold) { return std::abs (a) > threshold || std::abs (b) > threshold; }
+    };
+
+   #if JUCE_INTEL
+    struct SSEOps
+    {
+        using V = __m128;
+        static constexpr int width = 4;
+
+        static V load (const float* p) { return _mm_loadu_ps (p); }
+        static void store (float* p, V v) { _mm_storeu_ps (p, v); }
+        static V set1 (float v) { return _mm_set1_ps (v); }
+        static V add (V a, V b) { return _mm_add_ps (a, b); }
+        static V sub (V a, V b) { return _mm_sub_ps (a, b); }
+        static V mul (V a, V b) { return _mm_mul_ps (a, b); }
+        static V min (V a, V b) { return _mm_min_ps (a, b); }
+        static V max (V a, V b) { return _mm_max_ps (a, b); }
+        static V abs (V v) { return _mm_andnot_ps (_mm_set1_ps (-0.0f), v); }
+
+        static V flushBelow (V v, float threshold)
+        {
+            return _mm_andnot_ps (_mm_cmplt_ps (abs (v), _mm_set1_ps (threshold)), v);
+        }
+
+        static bool anyAbove (V a, V b, float threshold)
+        {
+            const V t = _mm_set1_ps (threshold);
+            return _mm_movemask_ps (_mm_or_ps (_mm_cmpgt_ps (abs (a), t), _mm_cmpgt_ps (abs (b), t))) != 0;
+        }
+    };
+   #endif
+
+   #if ORBIT_GRAIN_RENDERER_NEON
+    struct NEONOps
+    {
+        using V = float32x4_t;
+        static constexpr int width = 4;
+
+        static V load (const float* p) { return vld1q_f32 (p); }
+        static void store (float* p, V v) { vst1q_f32 (p, v); }
+        static V set1 (float v) { return vdupq_n_f32 (v); }
+        static V add (V a, V b) { return vaddq_f32 (a, b); }
+        static V sub (V a, V b) { return vsubq_f32 (a, b); }
+        static V mul (V a, V b) { return vmulq_f32 (a, b); }
+        static V min (V a, V b) { return vminq_f32 (a, b); }
+        static V max (V a, V b) { return vmaxq_f32 (a, b); }
+
+        static V flushBelow (V v, float threshold)
+        {
+            return vbslq_f32 (vcltq_f32 (vabsq_f32 (v), vdupq_n_f32 (threshold)), vdupq_n_f32 (0.0f), v);
+        }
+
+        static bool anyAbove (V a, V b, float threshold)
+        {
+            const V t = vdupq_n_f32 (threshold);
+            const uint32x4_t mask = vorrq_u32 (vcgtq_f32 (vabsq_f32 (a), t), vcgtq_f32 (vabsq_f32 (b), t));
+           #if defined (__aarch64__) || defined (_M_ARM64)
+            return vmaxvq_u32 (mask) != 0;
+           #else
+            const uint32x2_t folded = vorr_u32 (vget_low_u32 (mask), vget_high_u32 (mask));
+            return (vget_lane_u32 (folded, 0) | vget_lane_u32 (folded, 1)) != 0;
+           #endif
+        }
+    };
+   #endif
+}
+
+//==============================================================================
+namespace
+{
+    // Blackman-windowed sinc with its cutoff a little under Nyquist. Each row is
+    // normalised to unity gain so DC passes through unchanged at every phase.
+    struct SincTable
+    {
+        SincTable()
+        {
+            constexpr float cutoff = 0.9f;
+            constexpr float halfWidth = static_cast<float> (GrainKernels::sincTaps / 2);
+            const float pi = juce::MathConstants<float>::pi;
+
+            for (int phase = 0; phase <= GrainKernels::sincPhases; ++phase)
+            {
+                const float fraction = static_cast<float> (phase) / static_cast<float> (GrainKernels::sincPhases);
+                float* row = coefficients.data() + phase * GrainKernels::sincTaps;
+                float sum = 0.0f;
+
+                for (int t = 0; t < GrainKernels::sincTaps; ++t)
+                {
+                    // Tap t reads the sample at offset t - (sincTaps / 2 - 1) from the read index
+                    const float x = static_cast<float> (t + 1) - halfWidth - fraction;
+                    const float sinc = std::abs (x) < 1.0e-6f ? 1.0f : std::sin (pi * cutoff * x) / (pi * cutoff * x);
+                    const float window = std::abs (x) >= halfWidth ? 0.0f
+                                                                   : 0.42f + 0.5f * std::cos (pi * x / halfWidth)
+                                                                           + 0.08f * std::cos (2.0f * pi * x / halfWidth);
+                    row[t] = sinc * window;
+                    sum += row[t];
+                }
+
+                for (int t = 0; t < GrainKernels::sincTaps; ++t)
+                    row[t] /= sum;
+            }
+        }
+
+        // One extra row so a fraction that rounds up to 1.0 still has a kernel
+        std::array<float, (GrainKernels::sincPhases + 1) * GrainKernels::sincTaps> coefficients {};
+    };
+
+    const SincTable sincTable;
+}
+
+const float* GrainKernels::getSincTable()
+{
+    return sincTable.coefficients.data();
+}
+
+//==============================================================================
+void GrainRenderer::buildRenderBuffer (const juce::AudioBuffer<float>& audio, std::vector<float>& renderBuffer)
+{
+    const int numSamples = audio.getNumSamples();
+    const int numChannels = audio.getNumChannels();
+
+    if (numSamples <= 0 || numChannels <= 0)
+    {
+        renderBuffer.clear();
+        return;
+    }
+
+    renderBuffer.assign (static_cast<size_t> (numSamples + 2 * guardSamples), 0.0f);
+    float* mono = renderBuffer.data() + guardSamples;
+
+    const float channelMult = 1.0f / static_cast<float> (numChannels);
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sum = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel)
+            sum += audio.getReadPointer (channel)[i];
+        mono[i] = sum * channelMult;
+    }
+
+    // Wrap-around copies of the opposite end (modulo, so tiny files still work)
+    for (int i = 1; i <= guardSamples; ++i)
+    {
+        mono[-i] = mono[(numSamples - (i % numSamples)) % numSamples];
+        mono[numSamples - 1 + i] = mono[(i - 1) % numSamples];
+    }
+}
+
+GrainRenderer::Source GrainRenderer::getSource (const std::vector<float>& renderBuffer)
+{
+    Source source;
+
+    if (renderBuffer.size() > static_cast<size_t> (2 * guardSamples))
+    {
+        source.samples = renderBuffer.data() + guardSamples;
+        source.numSamples = static_cast<int> (renderBuffer.size()) - 2 * guardSamples;
+    }
+
+    return source;
+}
+
+//==============================================================================
+void GrainRenderer::render (const Source& source, const GrainBlock& grain, float* left, float* right)
+{
+    renderWith (getActiveInstructionSet(), source, grain, left, right);
+}
+
+void GrainRenderer::renderWith (InstructionSet instructionSet, const Source& source,
+                                const GrainBlock& grain, float* left, float* right)
+{
+    if (grain.numSamples <= 0 || source.numSamples <= 0 || source.samples == nullptr || left == nullptr)
+        return;
+
+    jassert (isSupported (instructionSet));
+
+   #if JUCE_INTEL
+    if (instructionSet == InstructionSet::AVX)
+        return GrainKernels::renderAVX (source, grain, left, right);
+
+    if (instructionSet == InstructionSet::SSE)
+        return GrainKernels::renderGrainWith<SSEOps> (source, grain, left, right);
+   #endif
+
+   #if ORBIT_GRAIN_RENDERER_NEON
+    if (instructionSet == InstructionSet::NEON)
+        return GrainKernels::renderGrainWith<NEONOps> (source, grain, left, right);
+   #endif
+
+    GrainKernels::renderGrainWith<ScalarOps> (source, grain, left, right);
+}
+
+//==============================================================================
+bool GrainRenderer::isSupported (InstructionSet instructionSet)
+{
+    if (instructionSet == InstructionSet::Scalar)
+        return true;
+
+   #if JUCE_INTEL
+    if (instructionSet == InstructionSet::SSE)
+        return juce::SystemStats::hasSSE2();
+
+    if (instructionSet == InstructionSet::AVX)
+        return juce::SystemStats::hasAVX();
+   #endif
+
+   #if ORBIT_GRAIN_RENDERER_NEON
+    if (instructionSet == InstructionSet::NEON)
+        return true;
+   #endif
+
+    return false;
+}
+
+GrainRenderer::InstructionSet GrainRenderer::getActiveInstructionSet()
+{
+    static const InstructionSet best = []
+    {
+        for (auto set : { InstructionSet::AVX, InstructionSet::SSE, InstructionSet::NEON })
+            if (isSupported (set))
+                return set;
+
+        return InstructionSet::Scalar;
+    }();
+
+    return best;
+}
+
+const char* GrainRenderer::getName (InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::Scalar: return "Scalar";
+        case InstructionSet::SSE:    return "SSE";
+        case InstructionSet::AVX:    return "AVX";
+        case InstructionSet::NEON:   return "NEON";
+    }
+
+    return "Unknown";
+}
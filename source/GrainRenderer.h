@@ -0,0 +1,74 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+// Inner loop for rendering one grain into a stereo output block.
+// Processes 4 (SSE/NEON) or 8 (AVX) samples per iteration, picking the widest
+// instruction set the CPU supports at runtime. The scalar path is kept as the
+// reference the vector paths are tested against.
+class GrainRenderer
+{
+public:
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE,
+        AVX,
+        NEON
+    };
+
+    // Order matches the "interpolation" parameter choices
+    enum class Interpolation
+    {
+        Linear,
+        Hermite,
+        Sinc
+    };
+
+    // Mono source audio. samples[-guardSamples] to samples[numSamples + guardSamples - 1]
+    // must be readable, with the guards holding wrapped copies of the other end.
+    struct Source
+    {
+        const float* samples = nullptr;
+        int numSamples = 0;
+    };
+
+    static constexpr int guardSamples = 4;
+
+    // Mixes a loaded file down to a guard-padded mono render buffer (done at load time)
+    static void buildRenderBuffer (const juce::AudioBuffer<float>& audio, std::vector<float>& renderBuffer);
+    static Source getSource (const std::vector<float>& renderBuffer);
+
+    // Block-constant gains for a grain
+    struct Gains
+    {
+        float amplitude = 1.0f;
+        float leftPan = 0.0f;
+        float rightPan = 0.0f;
+    };
+
+    // Everything needed to render one grain for one block
+    struct GrainBlock
+    {
+        float startSample = 0.0f;               // Grain start in the source
+        int playbackPosition = 0;               // Grain position at the first output sample
+        float pitchShift = 1.0f;
+        Interpolation interpolation = Interpolation::Hermite;
+        const float* grainEnvelope = nullptr;   // Per-sample grain window
+        const float* adsrEnvelope = nullptr;    // Per-sample particle ADSR
+        Gains start;                            // Gains at the end of the grain's previous block
+        Gains end;                              // Gains for this block
+        int rampSamples = 0;                    // Ramp length from start to end (normally the block size)
+        int numSamples = 0;
+    };
+
+    // Adds the grain into left/right (right may be nullptr for mono outputs)
+    static void render (const Source& source, const GrainBlock& grain, float* left, float* right);
+    static void renderWith (InstructionSet instructionSet, const Source& source,
+                            const GrainBlock& grain, float* left, float* right);
+
+    static InstructionSet getActiveInstructionSet();
+    static bool isSupported (InstructionSet instructionSet);
+    static const char* getName (InstructionSet instructionSet);
+};
@@ -0,0 +1,62 @@
+#include "GrainRenderer.h"
+
+// AVX path for GrainRenderer. Only this translation unit is compiled for AVX,
+// and it is only called after GrainRenderer has checked the CPU supports it.
+#if JUCE_INTEL
+
+#include <immintrin.h>
+#include <cmath>
+
+#if JUCE_CLANG
+ #pragma clang attribute push (__attribute__ ((target ("avx"))), apply_to = function)
+#elif JUCE_GCC
+ #pragma GCC push_options
+ #pragma GCC target ("avx")
+#endif
+
+#include "GrainRendererKernels.h"
+
+namespace
+{
+    struct AVXOps
+    {
+        using V = __m256;
+        static constexpr int width = 8;
+
+        static V load (const float* p) { return _mm256_loadu_ps (p); }
+        static void store (float* p, V v) { _mm256_storeu_ps (p, v); }
+        static V set1 (float v) { return _mm256_set1_ps (v); }
+        static V add (V a, V b) { return _mm256_add_ps (a, b); }
+        static V sub (V a, V b) { return _mm256_sub_ps (a, b); }
+        static V mul (V a, V b) { return _mm256_mul_ps (a, b); }
+        static V min (V a, V b) { return _mm256_min_ps (a, b); }
+        static V max (V a, V b) { return _mm256_max_ps (a, b); }
+        static V abs (V v) { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), v); }
+
+        static V flushBelow (V v, float threshold)
+        {
+            return _mm256_andnot_ps (_mm256_cmp_ps (abs (v), _mm256_set1_ps (threshold), _CMP_LT_OQ), v);
+        }
+
+        static bool anyAbove (V a, V b, float threshold)
+        {
+            const V t = _mm256_set1_ps (threshold);
+            return _mm256_movemask_ps (_mm256_or_ps (_mm256_cmp_ps (abs (a), t, _CMP_GT_OQ),
+                                                     _mm256_cmp_ps (abs (b), t, _CMP_GT_OQ))) != 0;
+        }
+    };
+}
+
+void GrainKernels::renderAVX (const GrainRenderer::Source& source, const GrainRenderer::GrainBlock& grain,
+                              float* left, float* right)
+{
+    renderGrainWith<AVXOps> (source, grain, left, right);
+}
+
+#if JUCE_CLANG
+ #pragma clang attribute pop
+#elif JUCE_GCC
+ #pragma GCC pop_options
+#endif
+
+#endif
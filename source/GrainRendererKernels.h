@@ -0,0 +1,295 @@
+#pragma once
+
+// Internal to GrainRenderer. The kernel is written once against a small
+// "Ops" interface and instantiated per instruction set. Each instruction set
+// lives in its own translation unit which includes this header after setting
+// its target options, so the instantiations pick up the right code generation.
+// Ops types are declared in anonymous namespaces, which keeps every
+// instantiation local to its translation unit. Anything added here must be
+// templated on Ops for the same reason, otherwise the linker may pick an AVX
+// copy of an inline function for the non-AVX paths.
+
+#include "GrainRenderer.h"
+#include <cmath>
+
+#if JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #define ORBIT_GRAIN_RENDERER_NEON 1
+#else
+ #define ORBIT_GRAIN_RENDERER_NEON 0
+#endif
+
+namespace GrainKernels
+{
+    // Defined in GrainRendererAVX.cpp
+    void renderAVX (const GrainRenderer::Source& source, const GrainRenderer::GrainBlock& grain,
+                    float* left, float* right);
+
+    //==============================================================================
+    // Wraps one read position into the source, splitting it into a sample index and fraction.
+    // The guard samples either side of the source mean taps near the index never need wrapping.
+    template <typename Ops>
+    inline void wrapPosition (const GrainRenderer::Source& source, float position, int& index, float& fraction)
+    {
+        const int length = source.numSamples;
+        const float lengthF = static_cast<float> (length);
+
+        position -= lengthF * std::floor (position / lengthF);
+        position = position >= lengthF ? position - lengthF : position;
+        position = position < 0.0f ? position + lengthF : position;
+
+        index = juce::jmin (static_cast<int> (position), length - 1);
+        fraction = juce::jlimit (0.0f, 1.0f, position - static_cast<float> (index));
+    }
+
+    //==============================================================================
+    // Interpolators. Each reads Ops::width read positions and returns the interpolated samples.
+    struct LinearInterpolator
+    {
+        template <typename Ops>
+        static typename Ops::V process (const GrainRenderer::Source& source, const float* positions)
+        {
+            using V = typename Ops::V;
+            constexpr int width = Ops::width;
+
+            alignas (32) float taps[2][width];
+            alignas (32) float fractions[width];
+
+            for (int k = 0; k < width; ++k)
+            {
+                int index;
+                wrapPosition<Ops> (source, positions[k], index, fractions[k]);
+                taps[0][k] = source.samples[index];
+                taps[1][k] = source.samples[index + 1];
+            }
+
+            const V y0 = Ops::load (taps[0]);
+            const V y1 = Ops::load (taps[1]);
+            return Ops::add (y0, Ops::mul (Ops::load (fractions), Ops::sub (y1, y0)));
+        }
+    };
+
+    struct HermiteInterpolator
+    {
+        template <typename Ops>
+        static typename Ops::V process (const GrainRenderer::Source& source, const float* positions)
+        {
+            using V = typename Ops::V;
+            constexpr int width = Ops::width;
+
+            alignas (32) float taps[4][width];
+            alignas (32) float fractions[width];
+
+            for (int k = 0; k < width; ++k)
+            {
+                int index;
+                wrapPosition<Ops> (source, positions[k], index, fractions[k]);
+
+                const float* samples = source.samples + index;
+                taps[0][k] = samples[-1];
+                taps[1][k] = samples[0];
+                taps[2][k] = samples[1];
+                taps[3][k] = samples[2];
+            }
+
+            const V y0 = Ops::load (taps[0]);
+            const V y1 = Ops::load (taps[1]);
+            const V y2 = Ops::load (taps[2]);
+            const V y3 = Ops::load (taps[3]);
+            const V fraction = Ops::load (fractions);
+
+            // Cubic Hermite interpolation
+            const V c0 = y1;
+            const V c1 = Ops::mul (Ops::set1 (0.5f), Ops::sub (y2, y0));
+            const V c2 = Ops::sub (Ops::add (Ops::sub (y0, Ops::mul (Ops::set1 (2.5f), y1)),
+                                             Ops::mul (Ops::set1 (2.0f), y2)),
+                                   Ops::mul (Ops::set1 (0.5f), y3));
+            const V c3 = Ops::add (Ops::mul (Ops::set1 (0.5f), Ops::sub (y3, y0)),
+                                   Ops::mul (Ops::set1 (1.5f), Ops::sub (y1, y2)));
+            const V audioSample = Ops::add (Ops::mul (Ops::add (Ops::mul (Ops::add (Ops::mul (c3, fraction), c2),
+                                                                          fraction), c1),
+                                                      fraction), c0);
+
+            // Clamp to prevent cubic overshoot
+            const V minSample = Ops::min (Ops::min (y0, y1), Ops::min (y2, y3));
+            const V maxSample = Ops::max (Ops::max (y0, y1), Ops::max (y2, y3));
+            return Ops::max (minSample, Ops::min (maxSample, audioSample));
+        }
+    };
+
+    // Windowed sinc, with the kernel precomputed for sincPhases fractional positions
+    // (see GrainRenderer.cpp). Row p holds the taps for fraction p / sincPhases.
+    constexpr int sincTaps = 8;
+    constexpr int sincPhases = 512;
+    const float* getSincTable();
+
+    struct SincInterpolator
+    {
+        template <typename Ops>
+        static typename Ops::V process (const GrainRenderer::Source& source, const float* positions)
+        {
+            using V = typename Ops::V;
+            constexpr int width = Ops::width;
+            constexpr int firstTap = 1 - sincTaps / 2;
+
+            alignas (32) float taps[sincTaps][width];
+            alignas (32) float coefficients[sincTaps][width];
+
+            const float* table = getSincTable();
+
+            for (int k = 0; k < width; ++k)
+            {
+                int index;
+                float fraction;
+                wrapPosition<Ops> (source, positions[k], index, fraction);
+
+                const int phase = static_cast<int> (fraction * static_cast<float> (sincPhases) + 0.5f);
+                const float* kernel = table + phase * sincTaps;
+                const float* samples = source.samples + index + firstTap;
+
+                for (int t = 0; t < sincTaps; ++t)
+                {
+                    taps[t][k] = samples[t];
+                    coefficients[t][k] = kernel[t];
+                }
+            }
+
+            V sum = Ops::mul (Ops::load (taps[0]), Ops::load (coefficients[0]));
+            for (int t = 1; t < sincTaps; ++t)
+                sum = Ops::add (sum, Ops::mul (Ops::load (taps[t]), Ops::load (coefficients[t])));
+
+            return sum;
+        }
+    };
+
+    static_assert (sincTaps / 2 <= GrainRenderer::guardSamples, "Sinc taps would read past the guard samples");
+
+    //==============================================================================
+    // Renders Ops::width consecutive output samples starting at grain offset `first`
+    template <typename Ops, typename Interpolator>
+    inline void renderChunk (const GrainRenderer::Source& source, const GrainRenderer::GrainBlock& grain,
+                             int first,
+                             const float* grainEnvelope, const float* adsrEnvelope,
+                             float* left, float* right)
+    {
+        using V = typename Ops::V;
+        constexpr int width = Ops::width;
+
+        alignas (32) float lanes[width];
+
+        for (int k = 0; k < width; ++k)
+            lanes[k] = static_cast<float> (grain.playbackPosition + first + k);
+
+        const V positions = Ops::add (Ops::set1 (grain.startSample),
+                                      Ops::mul (Ops::load (lanes), Ops::set1 (grain.pitchShift)));
+        Ops::store (lanes, positions);
+
+        V audioSample = Interpolator::template process<Ops> (source, lanes);
+
+        // Flush denormals
+        audioSample = Ops::flushBelow (audioSample, 1e-6f);
+
+        // Gains ramp linearly from start to end, so changes between blocks don't step
+        const float rampScale = grain.rampSamples > 0 ? 1.0f / static_cast<float> (grain.rampSamples) : 1.0f;
+        alignas (32) float ramp[width];
+
+        for (int k = 0; k < width; ++k)
+            ramp[k] = juce::jmin (1.0f, static_cast<float> (first + k + 1) * rampScale);
+
+        const float leftStart = grain.start.amplitude * grain.start.leftPan;
+        const float rightStart = grain.start.amplitude * grain.start.rightPan;
+        const float leftEnd = grain.end.amplitude * grain.end.leftPan;
+        const float rightEnd = grain.end.amplitude * grain.end.rightPan;
+
+        const V rampPosition = Ops::load (ramp);
+        const V leftGain = Ops::add (Ops::set1 (leftStart), Ops::mul (rampPosition, Ops::set1 (leftEnd - leftStart)));
+        const V rightGain = Ops::add (Ops::set1 (rightStart), Ops::mul (rampPosition, Ops::set1 (rightEnd - rightStart)));
+
+        const V envelope = Ops::mul (Ops::load (grainEnvelope), Ops::load (adsrEnvelope));
+
+        V leftSample = Ops::mul (audioSample, Ops::mul (leftGain, envelope));
+        V rightSample = Ops::mul (audioSample, Ops::mul (rightGain, envelope));
+
+        // Soft clip to prevent harsh digital clipping (rare, so done per lane)
+        if (Ops::anyAbove (leftSample, rightSample, 0.9f))
+        {
+            alignas (32) float l[width];
+            alignas (32) float r[width];
+            Ops::store (l, leftSample);
+            Ops::store (r, rightSample);
+
+            for (int k = 0; k < width; ++k)
+            {
+                if (std::abs (l[k]) > 0.9f)
+                    l[k] = std::tanh (l[k] * 0.9f) / 0.9f;
+                if (std::abs (r[k]) > 0.9f)
+                    r[k] = std::tanh (r[k] * 0.9f) / 0.9f;
+            }
+
+            leftSample = Ops::load (l);
+            rightSample = Ops::load (r);
+        }
+
+        Ops::store (left, Ops::add (Ops::load (left), leftSample));
+        if (right != nullptr)
+            Ops::store (right, Ops::add (Ops::load (right), rightSample));
+    }
+
+    //==============================================================================
+    template <typename Ops, typename Interpolator>
+    void renderGrain (const GrainRenderer::Source& source, const GrainRenderer::GrainBlock& grain,
+                      float* left, float* right)
+    {
+        constexpr int width = Ops::width;
+
+        int i = 0;
+        for (; i + width <= grain.numSamples; i += width)
+            renderChunk<Ops, Interpolator> (source, grain, i,
+                                            grain.grainEnvelope + i, grain.adsrEnvelope + i,
+                                            left + i, right != nullptr ? right + i : nullptr);
+
+        // Tail: run one more padded chunk and keep only the valid lanes, so every
+        // sample goes through the same arithmetic whatever the block length
+        const int remaining = grain.numSamples - i;
+        if (remaining > 0)
+        {
+            alignas (32) float grainEnvelope[width] = {};
+            alignas (32) float adsrEnvelope[width] = {};
+            alignas (32) float l[width] = {};
+            alignas (32) float r[width] = {};
+
+            for (int k = 0; k < remaining; ++k)
+            {
+                grainEnvelope[k] = grain.grainEnvelope[i + k];
+                adsrEnvelope[k] = grain.adsrEnvelope[i + k];
+            }
+
+            renderChunk<Ops, Interpolator> (source, grain, i, grainEnvelope, adsrEnvelope, l, r);
+
+            for (int k = 0; k < remaining; ++k)
+            {
+                left[i + k] += l[k];
+                if (right != nullptr)
+                    right[i + k] += r[k];
+            }
+        }
+    }
+
+    //==============================================================================
+    // Picks the interpolation kernel once per grain, so there's no per-sample branch
+    template <typename Ops>
+    void renderGrainWith (const GrainRenderer::Source& source, const GrainRenderer::GrainBlock& grain,
+                          float* left, float* right)
+    {
+        switch (grain.interpolation)
+        {
+            case GrainRenderer::Interpolation::Linear:
+                return renderGrain<Ops, LinearInterpolator> (source, grain, left, right);
+            case GrainRenderer::Interpolation::Sinc:
+                return renderGrain<Ops, SincInterpolator> (source, grain, left, right);
+            case GrainRenderer::Interpolation::Hermite:
+                break;
+        }
+
+        renderGrain<Ops, HermiteInterpolator> (source, grain, left, right);
+    }
+}
@@ -0,0 +1,118 @@
+#include "GravityField.h"
+
+//==============================================================================
+GravityField::GravityField()
+{
+    const auto numNodes = static_cast<size_t>(resolution * resolution);
+    fieldX.resize (numNodes, 0.0f);
+    fieldY.resize (numNodes, 0.0f);
+    potential.resize (numNodes, 0.0f);
+}
+
+void GravityField::setMasses (const ParticlePhysics::Mass* newMasses, int newNumMasses, juce::Rectangle<float> newBounds)
+{
+    jassert (newNumMasses <= maxMasses);
+    numMasses = juce::jmin (newNumMasses, maxMasses);
+    std::copy (newMasses, newMasses + numMasses, masses.begin());
+
+    bounds = newBounds;
+    nodesPerUnitX = bounds.getWidth() > 0.0f ? static_cast<float>(resolution - 1) / bounds.getWidth() : 0.0f;
+    nodesPerUnitY = bounds.getHeight() > 0.0f ? static_cast<float>(resolution - 1) / bounds.getHeight() : 0.0f;
+    nextRow = 0;
+}
+
+bool GravityField::buildRows (int numRows)
+{
+    const int endRow = juce::jmin (resolution, nextRow + numRows);
+    const float spacingX = bounds.getWidth() / static_cast<float>(resolution - 1);
+    const float spacingY = bounds.getHeight() / static_cast<float>(resolution - 1);
+
+    for (; nextRow < endRow; ++nextRow)
+    {
+        const float y = bounds.getY() + spacingY * static_cast<float>(nextRow);
+
+        for (int column = 0; column < resolution; ++column)
+        {
+            const float x = bounds.getX() + spacingX * static_cast<float>(column);
+            float ax = 0.0f, ay = 0.0f, phi = 0.0f;
+
+            for (int m = 0; m < numMasses; ++m)
+            {
+                const auto& mass = masses[static_cast<size_t>(m)];
+                const float dx = mass.position.x - x;
+                const float dy = mass.position.y - y;
+                const float distanceSquared = dx * dx + dy * dy;
+
+                // Same cutoff as the exact evaluation in ParticlePhysics
+                if (distanceSquared > ParticlePhysics::minMassDistanceSquared)
+                {
+                    const float inverseDistance = 1.0f / std::sqrt (distanceSquared);
+                    const float strengthOverDistance = mass.strength * inverseDistance;
+                    const float scale = strengthOverDistance * inverseDistance * inverseDistance;
+                    ax += dx * scale;
+                    ay += dy * scale;
+                    phi += strengthOverDistance;
+                }
+            }
+
+            const auto node = static_cast<size_t>(nextRow * resolution + column);
+            fieldX[node] = ax;
+            fieldY[node] = ay;
+            potential[node] = phi;
+        }
+    }
+
+    return isReady();
+}
+
+void GravityField::getCell (float x, float y, size_t& index, float& fracX, float& fracY) const
+{
+    constexpr float maxCoordinate = static_cast<float>(resolution - 1) - 1.0e-3f;
+    const float gridX = juce::jlimit (0.0f, maxCoordinate, (x - bounds.getX()) * nodesPerUnitX);
+    const float gridY = juce::jlimit (0.0f, maxCoordinate, (y - bounds.getY()) * nodesPerUnitY);
+
+    const int column = static_cast<int>(gridX);
+    const int row = static_cast<int>(gridY);
+    fracX = gridX - static_cast<float>(column);
+    fracY = gridY - static_cast<float>(row);
+    index = static_cast<size_t>(row * resolution + column);
+}
+
+GravityField::Sample GravityField::sample (juce::Point<float> position) const
+{
+    jassert (isReady());
+
+    size_t i;
+    float fracX, fracY;
+    getCell (position.x, position.y, i, fracX, fracY);
+
+    const auto below = i + static_cast<size_t>(resolution);
+    const auto lerp2 = [&] (const std::vector<float>& grid) {
+        const float top = grid[i] + (grid[i + 1] - grid[i]) * fracX;
+        const float bottom = grid[below] + (grid[below + 1] - grid[below]) * fracX;
+        return top + (bottom - top) * fracY;
+    };
+
+    return { { lerp2 (fieldX), lerp2 (fieldY) }, lerp2 (potential) };
+}
+
+void GravityField::addAccelerations (const float* px, const float* py, float* outX, float* outY, int count, float scale) const
+{
+    jassert (isReady());
+
+    for (int b = 0; b < count; ++b)
+    {
+        size_t i;
+        float fracX, fracY;
+        getCell (px[b], py[b], i, fracX, fracY);
+
+        const auto below = i + static_cast<size_t>(resolution);
+        const float w00 = (1.0f - fracX) * (1.0f - fracY);
+        const float w10 = fracX * (1.0f - fracY);
+        const float w01 = (1.0f - fracX) * fracY;
+        const float w11 = fracX * fracY;
+
+        outX[b] += scale * (w00 * fieldX[i] + w10 * fieldX[i + 1] + w01 * fieldX[below] + w11 * fieldX[below + 1]);
+        outY[b] += scale * (w00 * fieldY[i] + w10 * fieldY[i + 1] + w01 * fieldY[below] + w11 * fieldY[below + 1]);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ParticlePhysics.h"
+#include <array>
+
+//==============================================================================
+// Gravity of the mass points sampled on a grid over the canvas, so looking up the
+// pull at a point costs one bilinear fetch however many masses there are. Strengths
+// are per unit of gravity (mass multipliers); callers scale what they read.
+//
+// The grid is rebuilt a few rows at a time after the masses or bounds change, and
+// isn't usable until the rebuild completes. Close to a mass, where the pull changes
+// faster than the grid can follow, the sampled field is only a coarse approximation.
+class GravityField
+{
+public:
+    static constexpr int resolution = 128;   // Nodes along each side
+
+    GravityField();
+
+    // Starts a rebuild for the new configuration (no allocation, at most maxMasses masses)
+    void setMasses (const ParticlePhysics::Mass* masses, int numMasses, juce::Rectangle<float> newBounds);
+    juce::Rectangle<float> getBounds() const { return bounds; }
+
+    // Computes up to numRows more rows; returns true once the whole grid is built
+    bool buildRows (int numRows);
+    void build() { buildRows (resolution); }
+    bool isReady() const { return nextRow >= resolution; }
+
+    struct Sample
+    {
+        juce::Point<float> acceleration;   // Sum of strength * d / |d|^3
+        float potential = 0.0f;            // Sum of strength / |d|
+    };
+
+    Sample sample (juce::Point<float> position) const;
+
+    // Adds scale times the field at (px, py) to outX/outY for count bodies
+    void addAccelerations (const float* px, const float* py, float* outX, float* outY, int count, float scale) const;
+
+    static constexpr int maxMasses = 16;
+
+private:
+    std::vector<float> fieldX, fieldY, potential;
+    std::array<ParticlePhysics::Mass, maxMasses> masses;
+    int numMasses = 0;
+    juce::Rectangle<float> bounds;
+    float nodesPerUnitX = 0.0f, nodesPerUnitY = 0.0f;
+    int nextRow = resolution;
+
+    // Grid coordinates of a position, clamped so the 2x2 neighbourhood stays inside
+    void getCell (float x, float y, size_t& index, float& fracX, float& fracY) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GravityField)
+};
@@ -0,0 +1,40 @@
+#include "MidiEventQueue.h"
+
+//==============================================================================
+bool MidiEventQueue::push (const juce::MidiMessage& message, juce::int64 samplePosition)
+{
+    const int size = message.getRawDataSize();
+
+    if (size <= 0 || size > 3)
+        return false;
+
+    const auto write = writeIndex.load (std::memory_order_relaxed);
+
+    if (write - readIndex.load (std::memory_order_acquire) == capacity)
+        return false;
+
+    auto& event = events[write & mask];
+    event.samplePosition = samplePosition;
+    event.size = static_cast<juce::uint8>(size);
+    std::copy_n (message.getRawData(), size, event.data);
+
+    writeIndex.store (write + 1, std::memory_order_release);
+    return true;
+}
+
+const MidiEventQueue::Event* MidiEventQueue::front() const
+{
+    const auto read = readIndex.load (std::memory_order_relaxed);
+
+    if (read == writeIndex.load (std::memory_order_acquire))
+        return nullptr;
+
+    return &events[read & mask];
+}
+
+void MidiEventQueue::pop()
+{
+    const auto read = readIndex.load (std::memory_order_relaxed);
+    jassert (read != writeIndex.load (std::memory_order_acquire));
+    readIndex.store (read + 1, std::memory_order_release);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// Wait-free single-producer/single-consumer ring of short MIDI messages, each stamped
+// with the sample position it's due at. The message thread pushes, the audio thread
+// peeks and pops; neither side ever blocks or allocates.
+class MidiEventQueue
+{
+public:
+    static constexpr size_t capacity = 1024;   // Power of two
+
+    struct Event
+    {
+        juce::int64 samplePosition = 0;
+        juce::uint8 data[3] {};
+        juce::uint8 size = 0;
+
+        juce::MidiMessage toMessage() const { return juce::MidiMessage (data, size); }
+    };
+
+    // Producer only. Returns false if the queue is full or the message is longer than
+    // three bytes (sysex isn't carried).
+    bool push (const juce::MidiMessage& message, juce::int64 samplePosition);
+
+    // Consumer only. The oldest event, or nullptr if there is none; valid until pop().
+    const Event* front() const;
+    void pop();
+
+private:
+    static constexpr size_t mask = capacity - 1;
+    static_assert ((capacity & mask) == 0);
+
+    std::array<Event, capacity> events;
+
+    // Free-running counters on separate cache lines: only the producer writes writeIndex
+    // and only the consumer writes readIndex
+    alignas (64) std::atomic<size_t> writeIndex { 0 };
+    alignas (64) std::atomic<size_t> readIndex { 0 };
+};
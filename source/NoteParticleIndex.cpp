@@ -0,0 +1,56 @@
+#include "NoteParticleIndex.h"
+#include "Particle.h"
+
+//==============================================================================
+NoteParticleIndex::Links& NoteParticleIndex::getLinks (Particle& particle)
+{
+    return particle.noteLinks;
+}
+
+void NoteParticleIndex::add (Particle& particle)
+{
+    const int noteNumber = particle.getMidiNoteNumber();
+    auto& links = getLinks (particle);
+    jassert (! links.linked);
+
+    if (! juce::isPositiveAndBelow (noteNumber, numNotes) || links.linked)
+        return;
+
+    auto& head = heads[static_cast<size_t>(noteNumber)];
+
+    links.previous = nullptr;
+    links.next = head;
+    links.linked = true;
+
+    if (head != nullptr)
+        getLinks (*head).previous = &particle;
+
+    head = &particle;
+}
+
+void NoteParticleIndex::remove (Particle& particle)
+{
+    auto& links = getLinks (particle);
+
+    if (! links.linked)
+        return;
+
+    if (links.previous != nullptr)
+        getLinks (*links.previous).next = links.next;
+    else
+        heads[static_cast<size_t>(particle.getMidiNoteNumber())] = links.next;
+
+    if (links.next != nullptr)
+        getLinks (*links.next).previous = links.previous;
+
+    links = {};
+}
+
+void NoteParticleIndex::clear()
+{
+    for (auto& head : heads)
+    {
+        while (head != nullptr)
+            remove (*head);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+class Particle;
+
+//==============================================================================
+// The live particles of each MIDI note, as intrusive doubly-linked lists threaded
+// through the particles themselves. Adding and removing a particle is O(1) and
+// visiting a note's particles is O(particles on that note), with no allocation.
+class NoteParticleIndex
+{
+public:
+    static constexpr int numNotes = 128;
+
+    // Embedded in each Particle
+    struct Links
+    {
+        Particle* previous = nullptr;
+        Particle* next = nullptr;
+        bool linked = false;
+    };
+
+    // Particles with a note outside 0-127 aren't tracked. A particle's note mustn't
+    // change while it's in the index.
+    void add (Particle& particle);
+    void remove (Particle& particle);
+    void clear();
+
+    template <typename Callback>
+    void forEachParticle (int noteNumber, Callback&& callback) const
+    {
+        if (noteNumber < 0 || noteNumber >= numNotes)
+            return;
+
+        for (auto* particle = heads[static_cast<size_t>(noteNumber)]; particle != nullptr;)
+        {
+            // Read the link first so the callback may remove the particle
+            auto* next = getLinks (*particle).next;
+            callback (*particle);
+            particle = next;
+        }
+    }
+
+private:
+    std::array<Particle*, numNotes> heads {};
+
+    static Links& getLinks (Particle& particle);
+};
@@ -2,6 +2,7 @@
 #include "Logger.h"
 
 juce::Image Particle::starImage;
+std::atomic<int> Particle::nextUniqueID { 0 };
 std::vector<float> Particle::hannWindowTable;
 
 void Particle::initializeHannTable()
@@ -19,54 +20,74 @@ void Particle::initializeHannTable()
     }
 }
 
-float Particle::getHannWindowValue (float normalizedPosition)
-{
-    if (hannWindowTable.empty())
-        initializeHannTable();
-    
-    normalizedPosition = juce::jlimit (0.0f, 1.0f, normalizedPosition);
-    
-    float tablePos = normalizedPosition * static_cast<float>(HANN_TABLE_SIZE - 1);
-    size_t index0 = static_cast<size_t>(tablePos);
-    size_t index1 = juce::jmin (index0 + 1, static_cast<size_t>(HANN_TABLE_SIZE - 1));
-    
-    float frac = tablePos - static_cast<float>(index0);
-    float value = hannWindowTable[index0] + frac * (hannWindowTable[index1] - hannWindowTable[index0]);
-    
-    // Flush denormals to prevent noise artifacts
-    if (std::abs(value) < 1e-15f)
-        value = 0.0f;
-    
-    return value;
-}
-
 //==============================================================================
 Particle::Particle (juce::Point<float> initialPosition, juce::Point<float> initialVelocity, 
                     const juce::Rectangle<float>& bounds, int noteNumber,
                     float attack, float sustain, float sustainLinear, float release,
                     float velocityMultiplier, float pitch)
-    : position (initialPosition), velocity (initialVelocity), 
-      lifeTime (0.0f), 
-      midiNoteNumber (noteNumber),
-      adsrPhase (ADSRPhase::Attack),
-      adsrTime (0.0f),
-      attackTime (attack),
-      sustainLevel (sustain),
-      sustainLevelLinear (sustainLinear),
-      releaseTime (release),
-      adsrAmplitude (0.0f),
-      adsrAmplitudeLinear (0.0f),
-      initialVelocityMultiplier (velocityMultiplier), pitchShift (pitch),
-      canvasBounds (bounds),
-      currentSampleRate (0.0), 
-      samplesSinceLastGrainTrigger (0),
-      cachedTotalGrainSamples (2205),
-      lastPosition (initialPosition)
 {
-    activeGrains.reserve (32);
+    // Sized up front so nothing grows on the audio thread (grains and trail are held inline)
+    ownPhysics = std::make_unique<ParticlePhysics> (1);
+    physics = ownPhysics.get();
+    
+    controlTicks.reserve (8);
+    
+    respawn (initialPosition, initialVelocity, bounds, noteNumber,
+             attack, sustain, sustainLinear, release, velocityMultiplier, pitch);
 }
 
-void Particle::triggerNewGrain (int bufferLength)
+void Particle::respawn (juce::Point<float> initialPosition, juce::Point<float> initialVelocity, 
+                        const juce::Rectangle<float>& bounds, int noteNumber,
+                        float attack, float sustain, float sustainLinear, float release,
+                        float velocityMultiplier, float pitch)
+{
+    setPosition (initialPosition);
+    setVelocity (initialVelocity);
+    physics->ax[physicsSlot()] = 0.0f;
+    physics->ay[physicsSlot()] = 0.0f;
+    lifeTime = 0.0f;
+    
+    midiNoteNumber = noteNumber;
+    adsrPhase = ADSRPhase::Attack;
+    adsrTime = 0.0f;
+    attackTime = attack;
+    sustainLevel = sustain;
+    sustainLevelLinear = sustainLinear;
+    releaseTime = release;
+    adsrAmplitude = 0.0f;
+    adsrAmplitudeLinear = 0.0f;
+    adsrAmplitudeSmoothed = 0.0f;
+    releaseStartAmplitude = 0.0f;
+    releaseStartAmplitudeLinear = 0.0f;
+    
+    initialVelocityMultiplier = velocityMultiplier;
+    pitchShift = pitch;
+    
+    trail.clear();
+    activeGrains.clear();
+    
+    canvasBounds = bounds;
+    bounceMode = false;
+    
+    // Sample rate caches are rebuilt by the next updateSampleRate() call
+    grainSizeMs = 50.0f;
+    currentSampleRate = 0.0;
+    samplesUntilNextGrain = 0.0;
+    cachedTotalGrainSamples = 2205;
+    
+    justWrappedAround = false;
+    wraparoundSmoothingTime = 0.0f;
+    lastPosition = initialPosition;
+    lastGrainStartSample = 0.0f;
+    
+    // Nothing to ramp from yet: both ticks hold the spawn state
+    controlBlockLength = 0;
+    controlTicks.clear();
+    recordControlTick (rampFinishedOffset);
+    recordControlTick (rampFinishedOffset);
+}
+
+void Particle::triggerNewGrain (int bufferLength, int blockOffset, float subSampleDelay)
 {
     // Voice stealing when at max grains
     if (activeGrains.size() >= MAX_GRAINS_PER_PARTICLE)
@@ -85,30 +106,31 @@ void Particle::triggerNewGrain (int bufferLength)
         
         activeGrains.erase (activeGrains.begin() + oldestGrainIndex);
         
-        static int voiceStealCount = 0;
-        voiceStealCount++;
-        if (voiceStealCount % 50 == 1)
+        // Particles may render on different threads (GrainRenderPool)
+        static std::atomic<int> voiceStealCount { 0 };
+        if (voiceStealCount.fetch_add (1) % 50 == 0)
         {
             LOG_WARNING("Voice stealing: max grains reached, removed oldest grain");
         }
     }
     
-    int startSample = calculateGrainStartPosition (bufferLength);
+    int startSample = calculateGrainStartPosition (bufferLength, getControlPosition (blockOffset));
     activeGrains.push_back (Grain (startSample, cachedTotalGrainSamples));
+    activeGrains.back().blockOffset = blockOffset;
+    activeGrains.back().subSampleDelay = subSampleDelay;
 }
 
 void Particle::updateGrains (int numSamples)
 {
-    samplesSinceLastGrainTrigger += numSamples;
-    
     // Update each grain by actual samples rendered, not buffer size
     for (auto& grain : activeGrains)
     {
         int advanceAmount = (grain.samplesRenderedThisBuffer > 0) 
                           ? grain.samplesRenderedThisBuffer 
-                          : numSamples;
+                          : numSamples - grain.blockOffset;
         
         grain.playbackPosition += advanceAmount;
+        grain.blockOffset = 0;
         
         if (grain.playbackPosition >= cachedTotalGrainSamples)
             grain.active = false;
@@ -214,17 +236,134 @@ void Particle::updateADSR (float deltaTime)
     }
 }
 
-void Particle::updateADSRSample (double sampleRate)
+void Particle::renderADSRBlock (float* out, int numSamples)
 {
-    if (sampleRate <= 0.0)
+    if (currentSampleRate <= 0.0)
+    {
+        std::fill (out, out + numSamples, adsrAmplitudeSmoothed);
         return;
+    }
     
-    float deltaTime = static_cast<float>(1.0 / sampleRate);
-    updateADSR (deltaTime);
+    // Same curves as updateADSR, but each phase runs as one tight loop over its
+    // segment of the block. The one-pole smoothing coefficient is cached per sample rate.
+    const float deltaTime = adsrSampleDuration;
+    const float smoothingCoeff = adsrSmoothingCoeff;
+    float smoothed = adsrAmplitudeSmoothed;
+    int i = 0;
     
-    // One-pole lowpass smoothing to eliminate stepping artifacts
-    float smoothingCoeff = 1.0f - std::exp(-2.2f / (0.0005f * static_cast<float>(sampleRate)));
-    adsrAmplitudeSmoothed += smoothingCoeff * (adsrAmplitude - adsrAmplitudeSmoothed);
+    while (i < numSamples)
+    {
+        switch (adsrPhase)
+        {
+            case ADSRPhase::Attack:
+            {
+                const float invAttackTime = attackTime > 0.0f ? 1.0f / attackTime : 0.0f;
+                
+                while (i < numSamples)
+                {
+                    adsrTime += deltaTime;
+                    float linearProgress = attackTime > 0.0f ? juce::jmin (1.0f, adsrTime * invAttackTime) : 1.0f;
+                    adsrAmplitude = linearProgress * linearProgress;
+                    
+                    smoothed += smoothingCoeff * (adsrAmplitude - smoothed);
+                    out[i++] = smoothed;
+                    
+                    if (adsrAmplitude >= 1.0f)
+                    {
+                        adsrPhase = ADSRPhase::Decay;
+                        adsrTime = 0.0f;
+                        break;
+                    }
+                }
+                
+                adsrAmplitudeLinear = adsrAmplitude;
+                break;
+            }
+                
+            case ADSRPhase::Decay:
+            {
+                const float invDecayTime = 1.0f / decayTime;
+                float curve = 0.0f;
+                
+                while (i < numSamples)
+                {
+                    adsrTime += deltaTime;
+                    float remaining = 1.0f - juce::jmin (1.0f, adsrTime * invDecayTime);
+                    curve = 1.0f - remaining * remaining;
+                    adsrAmplitude = juce::jmax (sustainLevel, 1.0f - (curve * (1.0f - sustainLevel)));
+                    
+                    if (adsrTime >= decayTime)
+                    {
+                        adsrPhase = ADSRPhase::Sustain;
+                        adsrAmplitude = sustainLevel;
+                        adsrTime = 0.0f;
+                        curve = 1.0f;
+                    }
+                    
+                    smoothed += smoothingCoeff * (adsrAmplitude - smoothed);
+                    out[i++] = smoothed;
+                    
+                    if (adsrPhase != ADSRPhase::Decay)
+                        break;
+                }
+                
+                adsrAmplitudeLinear = juce::jmax (sustainLevelLinear, 1.0f - (curve * (1.0f - sustainLevelLinear)));
+                break;
+            }
+                
+            case ADSRPhase::Sustain:
+                adsrAmplitude = sustainLevel;
+                adsrAmplitudeLinear = sustainLevelLinear;
+                
+                for (; i < numSamples; ++i)
+                {
+                    smoothed += smoothingCoeff * (adsrAmplitude - smoothed);
+                    out[i] = smoothed;
+                }
+                break;
+                
+            case ADSRPhase::Release:
+            {
+                // Add grain fade duration to release time to prevent clicks
+                const float effectiveReleaseTime = releaseTime + 0.010f;
+                const float invReleaseTime = 1.0f / effectiveReleaseTime;
+                float curve = 0.0f;
+                
+                while (i < numSamples)
+                {
+                    adsrTime += deltaTime;
+                    float remaining = 1.0f - juce::jmin (1.0f, adsrTime * invReleaseTime);
+                    curve = (remaining * remaining) * (remaining * remaining);
+                    adsrAmplitude = juce::jmax (0.0f, releaseStartAmplitude * curve);
+                    
+                    smoothed += smoothingCoeff * (adsrAmplitude - smoothed);
+                    out[i++] = smoothed;
+                    
+                    if (adsrAmplitude <= 0.0f)
+                    {
+                        adsrPhase = ADSRPhase::Finished;
+                        break;
+                    }
+                }
+                
+                adsrAmplitudeLinear = juce::jmax (0.0f, releaseStartAmplitudeLinear * curve);
+                break;
+            }
+                
+            case ADSRPhase::Finished:
+                adsrAmplitude = 0.0f;
+                adsrAmplitudeLinear = 0.0f;
+                
+                for (; i < numSamples; ++i)
+                {
+                    smoothed += smoothingCoeff * (0.0f - smoothed);
+                    out[i] = smoothed;
+                }
+                break;
+        }
+    }
+    
+    adsrAmplitudeSmoothed = smoothed;
 }
 
 void Particle::triggerRelease()
@@ -241,6 +380,8 @@ void Particle::triggerRelease()
 //==============================================================================
 void Particle::update (float deltaTime)
 {
+    const auto position = getPosition();
+    
     updateADSR (deltaTime);
     
     if (justWrappedAround)
@@ -275,20 +416,52 @@ void Particle::update (float deltaTime)
     );
     
     lastPosition = position;
-    velocity += acceleration * deltaTime;
-    position += velocity * deltaTime;
-    acceleration = juce::Point<float> (0.0f, 0.0f);
-    
     lifeTime += deltaTime;
 }
 
 void Particle::applyForce (const juce::Point<float>& force)
 {
-    acceleration += force;
+    physics->ax[physicsSlot()] += force.x;
+    physics->ay[physicsSlot()] += force.y;
+}
+
+void Particle::setPosition (juce::Point<float> newPosition)
+{
+    physics->x[physicsSlot()] = newPosition.x;
+    physics->y[physicsSlot()] = newPosition.y;
+}
+
+void Particle::setVelocity (juce::Point<float> newVelocity)
+{
+    physics->vx[physicsSlot()] = newVelocity.x;
+    physics->vy[physicsSlot()] = newVelocity.y;
+}
+
+void Particle::attachPhysics (ParticlePhysics& store, int index)
+{
+    physics = &store;
+    physicsIndex = index;
+}
+
+void Particle::detachPhysics()
+{
+    const auto position = getPosition();
+    const auto velocity = getVelocity();
+    const auto acceleration = getAcceleration();
+    
+    physics = ownPhysics.get();
+    physicsIndex = 0;
+    
+    setPosition (position);
+    setVelocity (velocity);
+    physics->ax[0] = acceleration.x;
+    physics->ay[0] = acceleration.y;
 }
 
 void Particle::wrapAround (const juce::Rectangle<float>& bounds)
 {
+    auto position = getPosition();
+    
     if (position.x < bounds.getX())
         position.x = bounds.getRight();
     else if (position.x > bounds.getRight())
@@ -298,10 +471,15 @@ void Particle::wrapAround (const juce::Rectangle<float>& bounds)
         position.y = bounds.getBottom();
     else if (position.y > bounds.getBottom())
         position.y = bounds.getY();
+    
+    setPosition (position);
 }
 
 void Particle::bounceOff (const juce::Rectangle<float>& bounds)
 {
+    auto position = getPosition();
+    auto velocity = getVelocity();
+    
     if (position.x < bounds.getX())
     {
         position.x = bounds.getX();
@@ -323,12 +501,18 @@ void Particle::bounceOff (const juce::Rectangle<float>& bounds)
         position.y = bounds.getBottom();
         velocity.y = -std::abs(velocity.y);
     }
+    
+    setPosition (position);
+    setVelocity (velocity);
 }
 
-void Particle::draw (juce::Graphics& g)
+void Particle::draw (juce::Graphics& g, const ParticleSnapshot& snapshot, const ParticleSnapshot::Body& body)
 {
+    const auto position = body.position;
+    const auto& canvasBounds = snapshot.canvasBounds;
+    
     // Use linear ADSR for visuals (matches slider position)
-    float lifetimeAlpha = adsrAmplitudeLinear;
+    float lifetimeAlpha = body.adsrAmplitudeLinear;
     
     // Edge crossfade for visual wraparound
     const float edgeFadeZone = 50.0f;
@@ -340,7 +524,7 @@ void Particle::draw (juce::Graphics& g)
     juce::Point<float> ghostPosition = position;
     bool shouldDrawGhost = false;
     
-    if (!bounceMode)
+    if (!body.bounceMode)
     {
         if (distanceFromLeft < edgeFadeZone && canvasBounds.getWidth() > 0)
         {
@@ -362,9 +546,11 @@ void Particle::draw (juce::Graphics& g)
     
     auto drawTrailFrom = [&](juce::Point<float> offset, float alpha)
     {
-        if (trail.size() > 1)
+        const auto* trail = snapshot.trailPoints.data() + body.firstTrailPoint;
+        
+        if (body.numTrailPoints > 1)
         {
-            for (size_t i = 0; i < trail.size() - 1; ++i)
+            for (int i = 0; i < body.numTrailPoints - 1; ++i)
             {
                 const auto& p1 = trail[i];
                 const auto& p2 = trail[i + 1];
@@ -403,7 +589,7 @@ void Particle::draw (juce::Graphics& g)
         }
         else
         {
-            juce::Colour particleColor = activeGrains.empty()
+            juce::Colour particleColor = body.numActiveGrains == 0
                 ? juce::Colours::blue
                 : juce::Colours::red;
             g.setColour (particleColor.withAlpha (combinedAlpha));
@@ -422,6 +608,27 @@ void Particle::draw (juce::Graphics& g)
     }
 }
 
+void Particle::writeSnapshot (ParticleSnapshot& snapshot) const
+{
+    static_assert (maxTrailPoints + 1 <= ParticleSnapshot::maxTrailPointsPerParticle);
+    
+    if (snapshot.numBodies >= ParticleSnapshot::maxParticles)
+        return;
+    
+    auto& body = snapshot.bodies[static_cast<size_t>(snapshot.numBodies++)];
+    body.uniqueID = uniqueID;
+    body.position = getPosition();
+    body.adsrAmplitude = adsrAmplitude;
+    body.adsrAmplitudeLinear = adsrAmplitudeLinear;
+    body.numActiveGrains = static_cast<int>(activeGrains.size());
+    body.bounceMode = bounceMode;
+    body.firstTrailPoint = snapshot.numTrailPoints;
+    body.numTrailPoints = static_cast<int>(trail.size());
+    
+    std::copy (trail.begin(), trail.end(), snapshot.trailPoints.begin() + snapshot.numTrailPoints);
+    snapshot.numTrailPoints += body.numTrailPoints;
+}
+
 //==============================================================================
 void Particle::updateSampleRate (double sampleRate)
 {
@@ -434,6 +641,10 @@ void Particle::updateSampleRate (double sampleRate)
         int halfGrainSamples = cachedTotalGrainSamples / 2;
         cachedAttackSamples = halfGrainSamples;
         cachedReleaseSamples = halfGrainSamples;
+        
+        // One-pole lowpass smoothing for the ADSR to eliminate stepping artifacts
+        adsrSampleDuration = static_cast<float>(1.0 / sampleRate);
+        adsrSmoothingCoeff = 1.0f - std::exp(-2.2f / (0.0005f * static_cast<float>(sampleRate)));
     }
 }
 
@@ -446,28 +657,79 @@ void Particle::setGrainParameters (float grainSizeMsNew, float /*attackPercentNe
     }
 }
 
-bool Particle::shouldTriggerNewGrain (double sampleRate, float grainFrequencyHz)
+void Particle::scheduleGrains (double sampleRate, float grainFrequencyHz, int numSamples, int bufferLength)
 {
-    if (isFirstGrain)
+    // Grain times are kept in fractional samples, so the rate doesn't depend on the block size.
+    // A new particle's first grain starts at the top of its first block. A grain due between
+    // the last sample of one block and the next block starts on that block's first sample.
+    const double samplesPerPeriod = juce::jmax (1.0, sampleRate / static_cast<double>(grainFrequencyHz));
+    
+    while (samplesUntilNextGrain < static_cast<double>(numSamples))
     {
-        isFirstGrain = false;
-        samplesSinceLastGrainTrigger = 0;
-        return true;
+        const int blockOffset = static_cast<int>(std::ceil (samplesUntilNextGrain));
+        
+        if (blockOffset >= numSamples)
+            break;
+        
+        triggerNewGrain (bufferLength, blockOffset, static_cast<float>(blockOffset - samplesUntilNextGrain));
+        samplesUntilNextGrain += samplesPerPeriod;
     }
     
-    int samplesPerPeriod = static_cast<int>(sampleRate / grainFrequencyHz);
+    samplesUntilNextGrain -= numSamples;
+}
+
+//==============================================================================
+void Particle::reserveControlTicks (int maxTicksPerBlock)
+{
+    // The two carried over from the last block, plus this block's
+    controlTicks.reserve (static_cast<size_t>(maxTicksPerBlock + 2));
+}
+
+void Particle::beginControlBlock (int numSamples, int newControlInterval)
+{
+    if (controlTicks.size() > 2)
+        controlTicks.erase (controlTicks.begin(), controlTicks.end() - 2);
+    
+    // Clamped so a particle that goes a long time without ticks can't overflow
+    for (auto& tick : controlTicks)
+        tick.offset = juce::jmax (rampFinishedOffset, tick.offset - controlBlockLength);
     
-    if (samplesSinceLastGrainTrigger >= samplesPerPeriod)
-    {
-        samplesSinceLastGrainTrigger = 0;
-        return true;
-    }
+    controlBlockLength = numSamples;
+    controlInterval = newControlInterval;
+}
+
+void Particle::recordControlTick (int offset)
+{
+    ControlTick tick;
+    tick.offset = offset;
+    tick.position = getPosition();
+    tick.edgeFade = getEdgeFade();
+    controlTicks.push_back (tick);
+}
+
+juce::Point<float> Particle::getControlPosition (int offset) const
+{
+    // The last tick at or before offset, ramping in from the one before it
+    size_t index = controlTicks.size() - 1;
+    while (index > 1 && controlTicks[index].offset > offset)
+        --index;
+    
+    const auto& from = controlTicks[index - 1];
+    const auto& to = controlTicks[index];
+    const float progress = juce::jlimit (0.0f, 1.0f, static_cast<float>(offset - to.offset) / static_cast<float>(controlInterval));
     
-    return false;
+    // Don't sweep across the canvas when the particle wrapped between ticks
+    const auto delta = to.position - from.position;
+    if (std::abs (delta.x) > canvasBounds.getWidth() * 0.5f || std::abs (delta.y) > canvasBounds.getHeight() * 0.5f)
+        return to.position;
+    
+    return from.position + delta * progress;
 }
 
 float Particle::getPan() const
 {
+    const auto position = getPosition();
+    
     if (canvasBounds.getWidth() <= 0)
         return 0.0f;
     
@@ -477,6 +739,8 @@ float Particle::getPan() const
 
 Particle::EdgeFade Particle::getEdgeFade() const
 {
+    const auto position = getPosition();
+    
     EdgeFade result;
     result.amplitude = 1.0f;
     
@@ -518,61 +782,67 @@ Particle::EdgeFade Particle::getEdgeFade() const
     return result;
 }
 
-float Particle::getGrainAmplitude (const Grain& grain) const
+void Particle::renderGrainEnvelope (const Grain& grain, int playbackPosition, float* destination, int numSamples) const
 {
-    // Hann window for smooth grain envelope
-    if (grain.totalSamples <= 0)
-        return 0.0f;
+    // Hann fades at either end of a flat window, written for a whole block at once
+    jassert (! hannWindowTable.empty());
     
-    int grainPos = grain.playbackPosition;
+    // Fixed-duration fade-in/fade-out (10ms) regardless of grain size,
+    // capped to half the grain for short grains to prevent overlap
+    const int fadeSamples = static_cast<int>(0.010f * currentSampleRate);
+    const int fadeLength = juce::jmax (0, juce::jmin (fadeSamples, grain.totalSamples / 2));
+    const int fadeOutStart = grain.totalSamples - fadeLength;
+    const int grainEnd = juce::jmin (grain.totalSamples, cachedTotalGrainSamples);
     
-    // Past grain end = fully faded out
-    if (grainPos >= cachedTotalGrainSamples)
-        return 0.0f;
+    const float* table = hannWindowTable.data();
+    const float halfTable = 0.5f * static_cast<float>(HANN_TABLE_SIZE - 1);
+    const float rampStep = fadeLength > 1 ? halfTable / static_cast<float>(fadeLength - 1) : 0.0f;
     
-    // Fixed-duration fade-in/fade-out (10ms) regardless of grain size
-    const int fadeSamples = static_cast<int>(0.010f * currentSampleRate);
-    const int grainTotalSamples = grain.totalSamples;
-    const int halfGrain = grainTotalSamples / 2;
+    auto lookup = [table] (float tablePos)
+    {
+        const int index0 = static_cast<int>(tablePos);
+        const int index1 = juce::jmin (index0 + 1, HANN_TABLE_SIZE - 1);
+        const float frac = tablePos - static_cast<float>(index0);
+        return table[index0] + frac * (table[index1] - table[index0]);
+    };
     
-    // For short grains, cap fade to half grain size to prevent overlap
-    const int actualFadeInSamples = juce::jmin(fadeSamples, halfGrain);
-    const int actualFadeOutSamples = juce::jmin(fadeSamples, halfGrain);
+    int grainPos = playbackPosition;
+    const int blockEnd = grainPos + numSamples;
     
-    float grainEnvelope = 1.0f;
+    // Fade in: first half of Hann curve (0.0 → 1.0)
+    for (const int end = juce::jmin (blockEnd, fadeLength, grainEnd); grainPos < end; ++grainPos)
+        *destination++ = lookup (juce::jmin (halfTable, static_cast<float>(grainPos) * rampStep));
     
-    if (grainPos < actualFadeInSamples)
+    const int flatEnd = juce::jmin (blockEnd, fadeOutStart, grainEnd);
+    if (grainPos < flatEnd)
     {
-        // Fade in: first half of Hann curve (0.0 → 1.0)
-        float fadeProgress = static_cast<float>(grainPos) / static_cast<float>(actualFadeInSamples - 1);
-        fadeProgress = juce::jlimit (0.0f, 1.0f, fadeProgress);
-        float hannPos = fadeProgress * 0.5f;
-        grainEnvelope = getHannWindowValue(hannPos);
-    }
-    else if (grainPos >= grainTotalSamples - actualFadeOutSamples)
-    {
-        // Fade out: second half of Hann curve (1.0 → 0.0)
-        int samplesToEnd = grainTotalSamples - grainPos;
-        float fadeProgress = 1.0f - (static_cast<float>(samplesToEnd - 1) / static_cast<float>(actualFadeOutSamples - 1));
-        fadeProgress = juce::jlimit (0.0f, 1.0f, fadeProgress);
-        float hannPos = 0.5f + (fadeProgress * 0.5f);
-        grainEnvelope = getHannWindowValue(hannPos);
+        std::fill (destination, destination + (flatEnd - grainPos), 1.0f);
+        destination += flatEnd - grainPos;
+        grainPos = flatEnd;
     }
     
-    if (!std::isfinite(grainEnvelope))
-        grainEnvelope = 0.0f;
+    // Fade out: second half of Hann curve (1.0 → 0.0)
+    for (const int end = juce::jmin (blockEnd, grainEnd); grainPos < end; ++grainPos)
+        *destination++ = lookup (halfTable + juce::jmin (halfTable, static_cast<float>(grainPos - fadeOutStart) * rampStep));
     
-    return grainEnvelope;
+    // Past grain end = fully faded out
+    if (grainPos < blockEnd)
+        std::fill (destination, destination + (blockEnd - grainPos), 0.0f);
 }
 
 int Particle::calculateGrainStartPosition (int bufferLength)
+{
+    return calculateGrainStartPosition (bufferLength, getPosition());
+}
+
+int Particle::calculateGrainStartPosition (int bufferLength, juce::Point<float> atPosition) const
 {
     if (bufferLength <= 0 || canvasBounds.getHeight() <= 0)
         return 0;
     
     // Y position maps to audio buffer position
     // Y=0 (top) = end of sample, Y=height (bottom) = start of sample
-    float normalizedY = 1.0f - (position.y / canvasBounds.getHeight());
+    float normalizedY = 1.0f - (atPosition.y / canvasBounds.getHeight());
     normalizedY = juce::jlimit (0.0f, 1.0f, normalizedY);
     
     int startSample = static_cast<int>(normalizedY * bufferLength);
@@ -4,6 +4,11 @@
 #include <juce_graphics/juce_graphics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <array>
+#include "GrainRenderer.h"
+#include "ParticlePhysics.h"
+#include "FixedCapacityVector.h"
+#include "NoteParticleIndex.h"
+#include "ParticleSnapshot.h"
 
 //==============================================================================
 enum class ADSRPhase
@@ -24,6 +29,16 @@ struct Grain
     bool active = true;
     int samplesRenderedThisBuffer = 0;
     
+    // Where the grain starts within the block it was triggered in (0 once running),
+    // and how far its exact trigger time fell before that sample
+    int blockOffset = 0;
+    float subSampleDelay = 0.0f;
+    
+    // Gains the last block ended on, so the next block can ramp from them
+    GrainRenderer::Gains lastGains;
+    bool hasRendered = false;
+    
+    Grain() = default;
     Grain (int start, int size) : startSample (start), totalSamples (size) {}
 };
 
@@ -36,28 +51,44 @@ public:
               float attackTime, float sustainLevel, float sustainLevelLinear, float releaseTime,
               float initialVelocity = 1.0f, float pitchShift = 1.0f);
     ~Particle();
+    
+    // Reinitialises a recycled particle as if newly constructed, without reallocating
+    void respawn (juce::Point<float> position, juce::Point<float> velocity, 
+                  const juce::Rectangle<float>& canvasBounds, int midiNoteNumber,
+                  float attackTime, float sustainLevel, float sustainLevelLinear, float releaseTime,
+                  float initialVelocity = 1.0f, float pitchShift = 1.0f);
 
     //==============================================================================
+    // Advances everything but the motion itself, which ParticlePhysics::step does for all particles at once
     void update (float deltaTime);
     void applyForce (const juce::Point<float>& force);
     void wrapAround (const juce::Rectangle<float>& bounds);
     void bounceOff (const juce::Rectangle<float>& bounds);
     
-    // Getters
-    juce::Point<float> getPosition() const { return position; }
-    juce::Point<float> getVelocity() const { return velocity; }
+    // Getters (motion state lives in the attached ParticlePhysics store)
+    juce::Point<float> getPosition() const { return { physics->x[physicsSlot()], physics->y[physicsSlot()] }; }
+    juce::Point<float> getVelocity() const { return { physics->vx[physicsSlot()], physics->vy[physicsSlot()] }; }
+    juce::Point<float> getAcceleration() const { return { physics->ax[physicsSlot()], physics->ay[physicsSlot()] }; }
+    void setPosition (juce::Point<float> newPosition);
+    void setVelocity (juce::Point<float> newVelocity);
+    
+    // Called by ParticlePhysics. A detached particle keeps its state in a single-body store of its own.
+    void attachPhysics (ParticlePhysics& store, int index);
+    void detachPhysics();
+    int getPhysicsIndex() const { return physicsIndex; }
     float getLifeTime() const { return lifeTime; }
     bool isFinished() const { return adsrPhase == ADSRPhase::Finished; }
     int getMidiNoteNumber() const { return midiNoteNumber; }
     ADSRPhase getADSRPhase() const { return adsrPhase; }
     
-    // OPTIMIZATION: Unique ID for efficient note-to-particle mapping
+    // Stable handle for this particle object, kept when it's recycled by the pool
     int getUniqueID() const { return uniqueID; }
     static int getNextUniqueID() { return nextUniqueID++; }
     
     // ADSR control
     void updateADSR (float deltaTime);
-    void updateADSRSample (double sampleRate);
+    // Advances the ADSR by numSamples at the current sample rate, writing the smoothed amplitude
+    void renderADSRBlock (float* out, int numSamples);
     void triggerRelease();
     float getADSRAmplitude() const { return adsrAmplitude; }
     float getADSRAmplitudeSmoothed() const { return adsrAmplitudeSmoothed; }
@@ -66,9 +97,11 @@ public:
     float getGrainSizeMs() const { return grainSizeMs; }
     int getTotalGrainSamples() const { return cachedTotalGrainSamples; }
     
-    // Access to active grains
-    const std::vector<Grain>& getActiveGrains() const { return activeGrains; }
-    std::vector<Grain>& getActiveGrains() { return activeGrains; }
+    // Access to active grains (held inline, at most MAX_GRAINS_PER_PARTICLE)
+    static constexpr int MAX_GRAINS_PER_PARTICLE = 8;
+    using GrainList = FixedCapacityVector<Grain, MAX_GRAINS_PER_PARTICLE>;
+    const GrainList& getActiveGrains() const { return activeGrains; }
+    GrainList& getActiveGrains() { return activeGrains; }
     
     // Update total grain samples based on sample rate
     void updateSampleRate (double sampleRate);
@@ -76,8 +109,8 @@ public:
     // Set grain parameters (attack and release are percentages 0-100)
     void setGrainParameters (float grainSizeMs, float attackPercent, float releasePercent);
     
-    // Check if it's time to trigger a new grain based on frequency
-    bool shouldTriggerNewGrain (double sampleRate, float grainFrequencyHz);
+    // Triggers every grain due in the next numSamples samples at its exact offset in the block
+    void scheduleGrains (double sampleRate, float grainFrequencyHz, int numSamples, int bufferLength);
     
     // Setter to convert normalized position to actual sample index
     void setGrainStartSampleFromBuffer (int bufferLength);
@@ -88,9 +121,10 @@ public:
     
     // Update grain start position based on current Y position (for continuous grains)
     int calculateGrainStartPosition (int bufferLength);
+    int calculateGrainStartPosition (int bufferLength, juce::Point<float> atPosition) const;
     
-    // Trigger a new grain
-    void triggerNewGrain (int bufferLength);
+    // Trigger a new grain, starting blockOffset samples into the current block
+    void triggerNewGrain (int bufferLength, int blockOffset = 0, float subSampleDelay = 0.0f);
     
     float getPan() const;
     
@@ -100,9 +134,31 @@ public:
     };
     EdgeFade getEdgeFade() const;
     
-    float getGrainAmplitude (const Grain& grain) const;
+    // Physics runs at a control rate independent of the host block size. Each tick is recorded
+    // with the sample it lands on, and position-derived values ramp from the previous tick's
+    // to its own over the following control interval.
+    struct ControlTick
+    {
+        int offset = 0;   // Sample in the current block where this tick's ramp starts
+        juce::Point<float> position;
+        EdgeFade edgeFade;
+    };
+    
+    void reserveControlTicks (int maxTicksPerBlock);
+    // Drops ticks older than the last two and moves those onto the new block's timeline
+    void beginControlBlock (int numSamples, int controlInterval);
+    void recordControlTick (int offset);
+    const std::vector<ControlTick>& getControlTicks() const { return controlTicks; }
+    int getControlInterval() const { return controlInterval; }
+    // Interpolated position at a sample in the current block
+    juce::Point<float> getControlPosition (int offset) const;
+    
+    // Writes the grain window for numSamples samples from playbackPosition into the grain
+    void renderGrainEnvelope (const Grain& grain, int playbackPosition, float* destination, int numSamples) const;
     float getPitchShift() const { return pitchShift; }
     float getInitialVelocityMultiplier() const { return initialVelocityMultiplier; }
+    // Set by Merge collisions as the particle takes on another's mass
+    void setInitialVelocityMultiplier (float multiplier) { initialVelocityMultiplier = multiplier; }
     
     // Advance grain playback and clean up finished grains
     void updateGrains (int numSamples);
@@ -113,18 +169,25 @@ public:
     
     static void initializeHannTable();
     
-    void draw (juce::Graphics& g);
+    // Appends this particle to the snapshot, if there's room
+    void writeSnapshot (ParticleSnapshot& snapshot) const;
+    // Draws a particle from a snapshot, so painting never touches the live particles
+    static void draw (juce::Graphics& g, const ParticleSnapshot& snapshot, const ParticleSnapshot::Body& body);
 
 private:
-    juce::Point<float> position;
-    juce::Point<float> velocity;
-    juce::Point<float> acceleration;
+    std::unique_ptr<ParticlePhysics> ownPhysics;
+    ParticlePhysics* physics = nullptr;
+    int physicsIndex = 0;
+    size_t physicsSlot() const { return static_cast<size_t>(physicsIndex); }
+    
     float lifeTime = 0.0f;
-    float radius = 3.0f;
+    static constexpr float radius = 3.0f;
+    
+    const int uniqueID = getNextUniqueID();
+    static std::atomic<int> nextUniqueID;
     
-    // OPTIMIZATION: Unique ID for efficient particle tracking
-    int uniqueID;
-    static int nextUniqueID;
+    friend class NoteParticleIndex;
+    NoteParticleIndex::Links noteLinks;
     
     // ADSR envelope
     int midiNoteNumber = -1;
@@ -137,6 +200,8 @@ private:
     float adsrAmplitude = 0.0f;        // Logarithmic (for audio)
     float adsrAmplitudeLinear = 0.0f;  // Linear (for visuals)
     float adsrAmplitudeSmoothed = 0.0f;
+    float adsrSampleDuration = 0.0f;    // Cached in updateSampleRate
+    float adsrSmoothingCoeff = 0.0f;
     float releaseStartAmplitude = 0.0f;
     float releaseStartAmplitudeLinear = 0.0f;
     static constexpr float decayTime = 0.3f;
@@ -146,12 +211,9 @@ private:
     float pitchShift = 1.0f;
     
     // Trail system
-    struct TrailPoint {
-        juce::Point<float> position;
-        float age = 0.0f;
-    };
-    std::vector<TrailPoint> trail;
+    using TrailPoint = ParticleSnapshot::TrailPoint;
     static constexpr int maxTrailPoints = 60;
+    FixedCapacityVector<TrailPoint, maxTrailPoints + 1> trail;
     static constexpr float trailFadeTime = 1.0f;
     
     // Canvas bounds (order matters for constructor initializer list)
@@ -160,16 +222,14 @@ private:
     bool bounceMode = false;
     
     // Active grains (can have multiple overlapping)
-    std::vector<Grain> activeGrains;
-    static constexpr int MAX_GRAINS_PER_PARTICLE = 8;
+    GrainList activeGrains;
     
     // Grain parameters
     float grainSizeMs = 50.0f;
     
     // Grain triggering (order matters for constructor initializer list)
     double currentSampleRate = 44100.0;
-    int samplesSinceLastGrainTrigger = 0;
-    bool isFirstGrain = true;
+    double samplesUntilNextGrain = 0.0;   // From the start of the next block; keeps its fraction across blocks
     
     // Cached sample rate calculations
     int cachedTotalGrainSamples = 2205;
@@ -182,6 +242,12 @@ private:
     static bool envelopeLUTInitialized;
     static void initializeEnvelopeLUT();
     
+    // Control-rate history; always holds at least the previous and latest ticks
+    std::vector<ControlTick> controlTicks;
+    int controlBlockLength = 0;
+    int controlInterval = 32;
+    static constexpr int rampFinishedOffset = -(1 << 20);
+    
     // Wraparound smoothing to prevent clicks
     bool justWrappedAround = false;
     float wraparoundSmoothingTime = 0.0f;
@@ -194,5 +260,4 @@ private:
     // Hann window lookup table
     static std::vector<float> hannWindowTable;
     static constexpr int HANN_TABLE_SIZE = 512;
-    static float getHannWindowValue (float normalizedPosition);
 };
\ No newline at end of file
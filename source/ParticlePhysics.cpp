@@ -0,0 +1,403 @@
+#include "ParticlePhysics.h"
+#include "Particle.h"
+#include "GravityField.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+#if JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #define ORBIT_PARTICLE_PHYSICS_NEON 1
+ #include <arm_neon.h>
+#else
+ #define ORBIT_PARTICLE_PHYSICS_NEON 0
+#endif
+
+namespace
+{
+    // Bodies closer than this to a mass point feel no pull from it
+    constexpr float minDistanceSquared = ParticlePhysics::minMassDistanceSquared;
+
+    // strength * d / |d|^3 for one body, matching the vector paths below
+    inline void addGravityToBody (float dx, float dy, float strength, float& ax, float& ay)
+    {
+        const float distanceSquared = dx * dx + dy * dy;
+
+        if (distanceSquared > minDistanceSquared)
+        {
+            const float inverseDistance = 1.0f / std::sqrt (distanceSquared);
+            const float scale = strength * inverseDistance * inverseDistance * inverseDistance;
+            ax += dx * scale;
+            ay += dy * scale;
+        }
+    }
+}
+
+//==============================================================================
+void ParticlePhysics::addGravity (const float* px, const float* py, float* outX, float* outY, int count,
+                                  juce::Point<float> massPosition, float strength)
+{
+    int i = 0;
+
+   #if JUCE_INTEL
+    {
+        // rsqrt estimate plus one Newton-Raphson step, four bodies at a time
+        const __m128 massX = _mm_set1_ps (massPosition.x);
+        const __m128 massY = _mm_set1_ps (massPosition.y);
+        const __m128 strengthV = _mm_set1_ps (strength);
+        const __m128 minDistance = _mm_set1_ps (minDistanceSquared);
+        const __m128 half = _mm_set1_ps (0.5f);
+        const __m128 three = _mm_set1_ps (3.0f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 dx = _mm_sub_ps (massX, _mm_loadu_ps (px + i));
+            const __m128 dy = _mm_sub_ps (massY, _mm_loadu_ps (py + i));
+            const __m128 distanceSquared = _mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy));
+
+            __m128 inverse = _mm_rsqrt_ps (distanceSquared);
+            inverse = _mm_mul_ps (_mm_mul_ps (half, inverse),
+                                  _mm_sub_ps (three, _mm_mul_ps (distanceSquared, _mm_mul_ps (inverse, inverse))));
+
+            __m128 scale = _mm_mul_ps (strengthV, _mm_mul_ps (inverse, _mm_mul_ps (inverse, inverse)));
+            scale = _mm_and_ps (scale, _mm_cmpgt_ps (distanceSquared, minDistance));
+
+            _mm_storeu_ps (outX + i, _mm_add_ps (_mm_loadu_ps (outX + i), _mm_mul_ps (dx, scale)));
+            _mm_storeu_ps (outY + i, _mm_add_ps (_mm_loadu_ps (outY + i), _mm_mul_ps (dy, scale)));
+        }
+    }
+   #elif ORBIT_PARTICLE_PHYSICS_NEON
+    {
+        const float32x4_t massX = vdupq_n_f32 (massPosition.x);
+        const float32x4_t massY = vdupq_n_f32 (massPosition.y);
+        const float32x4_t strengthV = vdupq_n_f32 (strength);
+        const float32x4_t minDistance = vdupq_n_f32 (minDistanceSquared);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const float32x4_t dx = vsubq_f32 (massX, vld1q_f32 (px + i));
+            const float32x4_t dy = vsubq_f32 (massY, vld1q_f32 (py + i));
+            const float32x4_t distanceSquared = vmlaq_f32 (vmulq_f32 (dx, dx), dy, dy);
+
+            float32x4_t inverse = vrsqrteq_f32 (distanceSquared);
+            inverse = vmulq_f32 (inverse, vrsqrtsq_f32 (vmulq_f32 (distanceSquared, inverse), inverse));
+
+            float32x4_t scale = vmulq_f32 (strengthV, vmulq_f32 (inverse, vmulq_f32 (inverse, inverse)));
+            scale = vbslq_f32 (vcgtq_f32 (distanceSquared, minDistance), scale, vdupq_n_f32 (0.0f));
+
+            vst1q_f32 (outX + i, vmlaq_f32 (vld1q_f32 (outX + i), dx, scale));
+            vst1q_f32 (outY + i, vmlaq_f32 (vld1q_f32 (outY + i), dy, scale));
+        }
+    }
+   #endif
+
+    for (; i < count; ++i)
+        addGravityToBody (massPosition.x - px[i], massPosition.y - py[i], strength, outX[i], outY[i]);
+}
+
+void ParticlePhysics::addGravityScalar (const float* px, const float* py, float* outX, float* outY, int count,
+                                        juce::Point<float> massPosition, float strength)
+{
+    for (int i = 0; i < count; ++i)
+        addGravityToBody (massPosition.x - px[i], massPosition.y - py[i], strength, outX[i], outY[i]);
+}
+
+//==============================================================================
+ParticlePhysics::ParticlePhysics (int capacity)
+{
+    reserve (capacity);
+}
+
+void ParticlePhysics::reserve (int capacity)
+{
+    const auto size = static_cast<size_t>(juce::jmax (capacity, static_cast<int>(owners.size())));
+
+    for (auto* array : { &x, &y, &vx, &vy, &ax, &ay, &mass, &gravityX, &gravityY,
+                         &trialX, &trialY, &trialVx, &trialVy, &sumX, &sumY, &sumVx, &sumVy })
+        array->resize (size, 0.0f);
+
+    owners.resize (size, nullptr);
+
+    // Only needed between bodies, so a single particle's detached store skips them
+    if (size > 1)
+    {
+        tree.reserve (static_cast<int>(size));
+        spatialHash.reserve (static_cast<int>(size));
+    }
+}
+
+int ParticlePhysics::addBody (Particle& owner)
+{
+    // Only reached if the owner didn't reserve enough bodies
+    if (numBodies == static_cast<int>(owners.size()))
+        reserve (juce::jmax (8, numBodies * 2));
+
+    const int index = numBodies++;
+    const auto i = static_cast<size_t>(index);
+
+    const auto position = owner.getPosition();
+    const auto velocity = owner.getVelocity();
+    const auto acceleration = owner.getAcceleration();
+
+    x[i] = position.x;
+    y[i] = position.y;
+    vx[i] = velocity.x;
+    vy[i] = velocity.y;
+    ax[i] = acceleration.x;
+    ay[i] = acceleration.y;
+    mass[i] = owner.getInitialVelocityMultiplier();
+    owners[i] = &owner;
+
+    owner.attachPhysics (*this, index);
+    return index;
+}
+
+void ParticlePhysics::removeBody (int index)
+{
+    jassert (juce::isPositiveAndBelow (index, numBodies));
+
+    const auto i = static_cast<size_t>(index);
+    const auto last = static_cast<size_t>(numBodies - 1);
+
+    owners[i]->detachPhysics();
+
+    if (i != last)
+    {
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        ax[i] = ax[last];
+        ay[i] = ay[last];
+        mass[i] = mass[last];
+        owners[i] = owners[last];
+        owners[i]->attachPhysics (*this, index);
+    }
+
+    owners[last] = nullptr;
+    --numBodies;
+}
+
+void ParticlePhysics::setGravityField (const GravityField* field, float strength)
+{
+    jassert (field == nullptr || field->isReady());
+    gravityField = field;
+    gravityFieldStrength = strength;
+}
+
+void ParticlePhysics::setMutualGravity (float strength, float newOpeningAngle)
+{
+    mutualGravityStrength = strength;
+    openingAngle = newOpeningAngle;
+}
+
+void ParticlePhysics::step (float deltaTime, Integrator integrator, const Mass* masses, int numMasses)
+{
+    switch (integrator)
+    {
+        case Integrator::Euler:          stepEuler (deltaTime, masses, numMasses); break;
+        case Integrator::VelocityVerlet: stepVelocityVerlet (deltaTime, masses, numMasses); break;
+        case Integrator::RK4:            stepRK4 (deltaTime, masses, numMasses); break;
+    }
+
+    std::fill (ax.begin(), ax.begin() + numBodies, 0.0f);
+    std::fill (ay.begin(), ay.begin() + numBodies, 0.0f);
+}
+
+int ParticlePhysics::resolveCollisions (CollisionMode mode, float radius, juce::Rectangle<float> bounds)
+{
+    if (mode == CollisionMode::Off || numBodies < 2 || radius <= 0.0f)
+        return 0;
+
+    spatialHash.build (x.data(), y.data(), mass.data(), numBodies, bounds, radius);
+
+    const float radiusSquared = radius * radius;
+    int numResolved = 0;
+
+    spatialHash.forEachNearbyPair ([&] (int first, int second)
+    {
+        const auto i = static_cast<size_t>(first);
+        const auto j = static_cast<size_t>(second);
+
+        // One of them may have been merged away earlier in this pass
+        if (mass[i] <= 0.0f || mass[j] <= 0.0f)
+            return;
+
+        const float dx = x[j] - x[i];
+        const float dy = y[j] - y[i];
+        const float distanceSquared = dx * dx + dy * dy;
+
+        if (distanceSquared > radiusSquared)
+            return;
+
+        const float totalMass = mass[i] + mass[j];
+
+        if (mode == CollisionMode::Bounce)
+        {
+            if (distanceSquared <= 0.0f)
+                return;
+
+            const float inverseDistance = 1.0f / std::sqrt (distanceSquared);
+            const float nx = dx * inverseDistance;
+            const float ny = dy * inverseDistance;
+            const float approachSpeed = (vx[j] - vx[i]) * nx + (vy[j] - vy[i]) * ny;
+
+            // Already separating
+            if (approachSpeed >= 0.0f)
+                return;
+
+            const float impulse = 2.0f * approachSpeed / totalMass;
+            vx[i] += impulse * mass[j] * nx;
+            vy[i] += impulse * mass[j] * ny;
+            vx[j] -= impulse * mass[i] * nx;
+            vy[j] -= impulse * mass[i] * ny;
+        }
+        else
+        {
+            const auto survivor = mass[i] >= mass[j] ? i : j;
+            const auto absorbed = survivor == i ? j : i;
+
+            const float mergedX = (mass[i] * x[i] + mass[j] * x[j]) / totalMass;
+            const float mergedY = (mass[i] * y[i] + mass[j] * y[j]) / totalMass;
+            const float mergedVx = (mass[i] * vx[i] + mass[j] * vx[j]) / totalMass;
+            const float mergedVy = (mass[i] * vy[i] + mass[j] * vy[j]) / totalMass;
+
+            // The absorbed body fades out where the merged one carries on
+            for (auto k : { survivor, absorbed })
+            {
+                x[k] = mergedX;
+                y[k] = mergedY;
+                vx[k] = mergedVx;
+                vy[k] = mergedVy;
+            }
+
+            // The survivor plays for both, so its grains get louder with the mass it gains
+            auto& survivorOwner = *owners[survivor];
+            survivorOwner.setInitialVelocityMultiplier (juce::jmin (maxMergedVelocityMultiplier,
+                                                                    survivorOwner.getInitialVelocityMultiplier() * totalMass / mass[survivor]));
+
+            mass[survivor] = totalMass;
+            mass[absorbed] = 0.0f;
+            owners[absorbed]->triggerRelease();
+        }
+
+        ++numResolved;
+    });
+
+    return numResolved;
+}
+
+void ParticlePhysics::computeAccelerations (const float* px, const float* py, float* outX, float* outY,
+                                            const Mass* masses, int numMasses)
+{
+    std::copy (ax.begin(), ax.begin() + numBodies, outX);
+    std::copy (ay.begin(), ay.begin() + numBodies, outY);
+
+    if (gravityField != nullptr)
+        gravityField->addAccelerations (px, py, outX, outY, numBodies, gravityFieldStrength);
+    else
+        for (int m = 0; m < numMasses; ++m)
+            addGravity (px, py, outX, outY, numBodies, masses[m].position, masses[m].strength);
+
+    if (mutualGravityStrength > 0.0f && numBodies > 1)
+    {
+        tree.build (px, py, mass.data(), numBodies);
+        tree.addAccelerations (px, py, mass.data(), outX, outY, numBodies, mutualGravityStrength, openingAngle);
+    }
+}
+
+// The per-body loops below are plain array arithmetic, which the compiler vectorises
+void ParticlePhysics::stepEuler (float deltaTime, const Mass* masses, int numMasses)
+{
+    computeAccelerations (x.data(), y.data(), gravityX.data(), gravityY.data(), masses, numMasses);
+
+    for (size_t i = 0; i < static_cast<size_t>(numBodies); ++i)
+    {
+        vx[i] += gravityX[i] * deltaTime;
+        vy[i] += gravityY[i] * deltaTime;
+        x[i] += vx[i] * deltaTime;
+        y[i] += vy[i] * deltaTime;
+    }
+}
+
+void ParticlePhysics::stepVelocityVerlet (float deltaTime, const Mass* masses, int numMasses)
+{
+    const float halfStep = 0.5f * deltaTime;
+    const auto count = static_cast<size_t>(numBodies);
+
+    // Half kick, drift, then the second half kick with the forces at the new positions
+    computeAccelerations (x.data(), y.data(), gravityX.data(), gravityY.data(), masses, numMasses);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vx[i] += gravityX[i] * halfStep;
+        vy[i] += gravityY[i] * halfStep;
+        x[i] += vx[i] * deltaTime;
+        y[i] += vy[i] * deltaTime;
+    }
+
+    computeAccelerations (x.data(), y.data(), gravityX.data(), gravityY.data(), masses, numMasses);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vx[i] += gravityX[i] * halfStep;
+        vy[i] += gravityY[i] * halfStep;
+    }
+}
+
+void ParticlePhysics::stepRK4 (float deltaTime, const Mass* masses, int numMasses)
+{
+    const auto count = static_cast<size_t>(numBodies);
+
+    // Stage k: derivative (trialV, gravity) at trial position; sums weight them 1, 2, 2, 1
+    std::copy (vx.begin(), vx.begin() + numBodies, trialVx.begin());
+    std::copy (vy.begin(), vy.begin() + numBodies, trialVy.begin());
+    computeAccelerations (x.data(), y.data(), gravityX.data(), gravityY.data(), masses, numMasses);
+
+    std::fill (sumX.begin(), sumX.begin() + numBodies, 0.0f);
+    std::fill (sumY.begin(), sumY.begin() + numBodies, 0.0f);
+    std::fill (sumVx.begin(), sumVx.begin() + numBodies, 0.0f);
+    std::fill (sumVy.begin(), sumVy.begin() + numBodies, 0.0f);
+
+    const float weights[] = { 1.0f, 2.0f, 2.0f, 1.0f };
+    const float nextStageStep[] = { 0.5f * deltaTime, 0.5f * deltaTime, deltaTime };
+
+    for (int stage = 0; stage < 4; ++stage)
+    {
+        const float weight = weights[stage];
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            sumX[i] += weight * trialVx[i];
+            sumY[i] += weight * trialVy[i];
+            sumVx[i] += weight * gravityX[i];
+            sumVy[i] += weight * gravityY[i];
+        }
+
+        if (stage == 3)
+            break;
+
+        const float h = nextStageStep[stage];
+
+        // Next trial state from this stage's derivative; trialV is read before it's replaced
+        for (size_t i = 0; i < count; ++i)
+        {
+            trialX[i] = x[i] + trialVx[i] * h;
+            trialY[i] = y[i] + trialVy[i] * h;
+            trialVx[i] = vx[i] + gravityX[i] * h;
+            trialVy[i] = vy[i] + gravityY[i] * h;
+        }
+
+        computeAccelerations (trialX.data(), trialY.data(), gravityX.data(), gravityY.data(), masses, numMasses);
+    }
+
+    const float sixth = deltaTime / 6.0f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] += sumX[i] * sixth;
+        y[i] += sumY[i] * sixth;
+        vx[i] += sumVx[i] * sixth;
+        vy[i] += sumVy[i] * sixth;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include "BarnesHutTree.h"
+#include "SpatialHash.h"
+#include <vector>
+
+class Particle;
+class GravityField;
+
+//==============================================================================
+// Motion state for a set of particles, kept as contiguous arrays so forces can be
+// summed and integrated a vector of particles at a time. Live bodies are packed at
+// the front: removing one moves the last body into its slot and rebinds its owner.
+class ParticlePhysics
+{
+public:
+    explicit ParticlePhysics (int capacity = 0);
+
+    // Not real-time safe
+    void reserve (int capacity);
+
+    int getNumBodies() const { return numBodies; }
+
+    // Binds the particle to a new body, carrying over its current motion state
+    int addBody (Particle& owner);
+    // Unbinds the body's particle (which keeps its state) and fills the gap
+    void removeBody (int index);
+
+    // Order matches the integrator parameter choices
+    enum class Integrator
+    {
+        Euler,            // Semi-implicit (symplectic) Euler, one force evaluation
+        VelocityVerlet,   // Leapfrog kick-drift-kick, two force evaluations
+        RK4               // Classic Runge-Kutta, four force evaluations
+    };
+
+    struct Mass
+    {
+        juce::Point<float> position;
+        float strength = 0.0f;   // Pulls with strength / distance^2 (nothing within 5 units)
+    };
+
+    static constexpr float minMassDistanceSquared = 5.0f * 5.0f;
+
+    // Adds the pull of one mass to outX/outY for count bodies at (px, py). Runs four bodies
+    // at a time with an approximate reciprocal square root where SSE or NEON is available;
+    // addGravityScalar is the exact one-at-a-time version it's checked against.
+    static void addGravity (const float* px, const float* py, float* outX, float* outY, int count,
+                            juce::Point<float> massPosition, float strength);
+    static void addGravityScalar (const float* px, const float* py, float* outX, float* outY, int count,
+                                  juce::Point<float> massPosition, float strength);
+
+    // When set, gravity is read from the field (scaled by strength) instead of being
+    // summed over the masses passed to step. The field must be ready while it's set.
+    void setGravityField (const GravityField* field, float strength);
+
+    // Bodies also pull on each other with strength * mass / distance^2, summed over a
+    // Barnes-Hut tree rebuilt at every force evaluation. A strength of 0 turns this off;
+    // see BarnesHutTree for the opening angle.
+    void setMutualGravity (float strength, float openingAngle);
+
+    // Advances every body by deltaTime under the masses' gravity plus whatever was
+    // accumulated in ax/ay (held constant over the step), then clears ax/ay
+    void step (float deltaTime, Integrator integrator, const Mass* masses, int numMasses);
+
+    // Order matches the collision parameter choices
+    enum class CollisionMode
+    {
+        Off,
+        Bounce,   // Elastic collisions, weighted by mass
+        Merge     // The heavier body takes on the lighter one's mass and momentum; the lighter is released
+    };
+
+    // Grain gain a merged body's velocity multiplier can grow to
+    static constexpr float maxMergedVelocityMultiplier = 2.0f;
+
+    // Resolves every pair of bodies within radius of each other, found with a spatial hash
+    // over bounds. Bodies without mass (including merged-away ones) don't collide.
+    // Returns the number of pairs resolved.
+    int resolveCollisions (CollisionMode mode, float radius, juce::Rectangle<float> bounds);
+
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    std::vector<float> ax, ay;
+    std::vector<float> mass;   // Gravitational mass for mutual gravity (the note's MIDI velocity)
+
+private:
+    std::vector<Particle*> owners;
+    int numBodies = 0;
+
+    const GravityField* gravityField = nullptr;
+    float gravityFieldStrength = 0.0f;
+
+    BarnesHutTree tree;
+    SpatialHash spatialHash;
+    float mutualGravityStrength = 0.0f;
+    float openingAngle = 0.5f;
+
+    // Integrator scratch, sized with the bodies
+    std::vector<float> gravityX, gravityY;
+    std::vector<float> trialX, trialY, trialVx, trialVy;
+    std::vector<float> sumX, sumY, sumVx, sumVy;
+
+    // Writes ax/ay plus gravity at (px, py) into outX/outY
+    void computeAccelerations (const float* px, const float* py, float* outX, float* outY,
+                               const Mass* masses, int numMasses);
+    void stepEuler (float deltaTime, const Mass* masses, int numMasses);
+    void stepVelocityVerlet (float deltaTime, const Mass* masses, int numMasses);
+    void stepRK4 (float deltaTime, const Mass* masses, int numMasses);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParticlePhysics)
+};
@@ -0,0 +1,36 @@
+#include "ParticlePool.h"
+
+//==============================================================================
+void ParticlePool::reserve (int capacity)
+{
+    const auto size = static_cast<size_t>(juce::jmax (0, capacity));
+
+    if (size <= slots.size())
+        return;
+
+    slots.reserve (size);
+    freeList.reserve (size);
+
+    while (slots.size() < size)
+    {
+        slots.push_back (std::make_unique<Particle> (juce::Point<float>(), juce::Point<float>(), juce::Rectangle<float>(), -1,
+                                                     0.01f, 0.7f, 0.7f, 0.5f));
+        freeList.push_back (slots.back().get());
+    }
+}
+
+Particle* ParticlePool::acquire()
+{
+    if (freeList.empty())
+        return nullptr;
+
+    auto* particle = freeList.back();
+    freeList.pop_back();
+    return particle;
+}
+
+void ParticlePool::release (Particle* particle)
+{
+    jassert (particle != nullptr && freeList.size() < slots.size());
+    freeList.push_back (particle);
+}
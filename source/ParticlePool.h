@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Particle.h"
+
+//==============================================================================
+// Every particle the processor can have alive at once, allocated up front and handed
+// out through a free list, so spawning and removing a particle on the audio thread is
+// constant time and never touches the heap.
+class ParticlePool
+{
+public:
+    // Grows the pool to at least capacity particles (never shrinks). Not real-time safe.
+    void reserve (int capacity);
+
+    int getCapacity() const { return static_cast<int>(slots.size()); }
+    int getNumFree() const { return static_cast<int>(freeList.size()); }
+
+    // Returns nullptr when every particle is in use
+    Particle* acquire();
+    void release (Particle* particle);
+
+    // Every particle, live or free
+    template <typename Callback>
+    void forEachParticle (Callback&& callback)
+    {
+        for (auto& particle : slots)
+            callback (*particle);
+    }
+
+private:
+    std::vector<std::unique_ptr<Particle>> slots;
+    std::vector<Particle*> freeList;   // Reserved to the pool size, so release never allocates
+};
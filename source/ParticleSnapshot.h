@@ -0,0 +1,45 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <vector>
+
+//==============================================================================
+// What the GUI needs to draw the particles, copied out by the audio thread after each
+// block (see PluginProcessor::readParticleSnapshot). Plain data, sized once up front.
+struct ParticleSnapshot
+{
+    static constexpr int maxParticles = 256;
+    static constexpr int maxTrailPointsPerParticle = 61;
+
+    struct TrailPoint
+    {
+        juce::Point<float> position;
+        float age = 0.0f;
+    };
+
+    struct Body
+    {
+        int uniqueID = 0;
+        juce::Point<float> position;
+        float adsrAmplitude = 0.0f;         // Logarithmic, as heard
+        float adsrAmplitudeLinear = 0.0f;   // Linear, for visuals
+        int numActiveGrains = 0;
+        bool bounceMode = false;
+        int firstTrailPoint = 0;            // Range in trailPoints
+        int numTrailPoints = 0;
+    };
+
+    ParticleSnapshot()
+        : bodies (static_cast<size_t>(maxParticles)),
+          trailPoints (static_cast<size_t>(maxParticles * maxTrailPointsPerParticle))
+    {
+    }
+
+    // Only the first numBodies / numTrailPoints entries are valid
+    std::vector<Body> bodies;
+    std::vector<TrailPoint> trailPoints;
+    int numBodies = 0;
+    int numTrailPoints = 0;
+    int totalParticles = 0;   // Live particles, including any past maxParticles
+    juce::Rectangle<float> canvasBounds;
+};
@@ -142,9 +142,9 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     canvas.setCustomTypeface (customTypeface);
     
     canvas.onAudioFileLoaded = [this](const juce::File& file) {
+        // The canvas picks the decoded file up in timerCallback
         processorRef.loadAudioFile (file);
         audioFileLabel.setText (file.getFileName(), juce::dontSendNotification);
-        canvas.setAudioBuffer (processorRef.getAudioBuffer());
     };
     
     addAndMakeVisible (audioFileLabel);
@@ -280,7 +280,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     {
         auto loadedFile = processorRef.getLoadedAudioFile();
         audioFileLabel.setText (loadedFile.getFileName(), juce::dontSendNotification);
-        canvas.setAudioBuffer (processorRef.getAudioBuffer());
+        canvas.setSample (processorRef.getLoadedSample());
         LOG_INFO("Editor initialized with restored audio file: " + loadedFile.getFullPathName());
     }
 }
@@ -301,14 +301,18 @@ PluginEditor::~PluginEditor()
 void PluginEditor::timerCallback()
 {
     // Update particle count display
-    auto& lock = canvas.getParticlesLock();
-    const juce::ScopedLock scopedLock (lock);
-    auto* particles = canvas.getParticles();
+    int count = processorRef.readParticleSnapshot().totalParticles;
+    particleCountLabel.setText (juce::String(count), juce::dontSendNotification);
     
-    if (particles != nullptr)
+    // Show a file once it has finished loading in the background
+    auto sample = processorRef.getLoadedSample();
+    if (sample != canvas.getSample())
     {
-        int count = particles->size();
-        particleCountLabel.setText (juce::String(count), juce::dontSendNotification);
+        if (sample != nullptr)
+            audioFileLabel.setText (sample->file.getFileName(), juce::dontSendNotification);
+        
+        canvas.setSample (sample);
+        repaint();
     }
 }
 
@@ -520,10 +524,12 @@ void PluginEditor::drawADSRCurve (juce::Graphics& g)
 
 void PluginEditor::drawGrainSizeWaveform (juce::Graphics& g)
 {
-    const auto* audioBuffer = processorRef.getAudioBuffer();
-    if (audioBuffer == nullptr || audioBuffer->getNumSamples() == 0)
+    const auto sample = processorRef.getLoadedSample();
+    if (sample == nullptr || sample->audio.getNumSamples() == 0)
         return;
     
+    const auto* audioBuffer = &sample->audio;
+    
     auto canvasBounds = canvas.getBounds();
     float canvasWidth = canvasBounds.getWidth();
     float canvasHeight = canvasBounds.getHeight();
@@ -613,11 +619,13 @@ void PluginEditor::drawGrainSizeWaveform (juce::Graphics& g)
         // Single waveform for grain size visualization
         // Get grain size in milliseconds and convert to samples
         auto grainSizeMs = grainSizeSlider.getValue();
-        auto sampleRate = processorRef.getSampleRate();
+        // The display buffer is at the file's own rate, whatever the render buffer was converted to
+        auto sampleRate = sample->sampleRate;
         if (sampleRate <= 0.0)
             sampleRate = 44100.0; // Fallback
         
-        int grainSizeSamples = static_cast<int>((grainSizeMs / 1000.0) * sampleRate);
+        // A streamed file's display buffer is an overview, overviewStride source samples per sample
+        int grainSizeSamples = static_cast<int>((grainSizeMs / 1000.0) * sampleRate) / sample->overviewStride;
         grainSizeSamples = juce::jlimit (1, audioBuffer->getNumSamples(), grainSizeSamples);
         
         // Sample from the middle of the audio buffer for the grain size duration
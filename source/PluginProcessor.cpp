@@ -3,6 +3,7 @@
 #include "Logger.h"
 #include "Canvas.h"
 #include "Particle.h"
+#include "GrainRenderer.h"
 #include <juce_audio_formats/juce_audio_formats.h>
 
 //==============================================================================
@@ -19,6 +20,24 @@ PluginProcessor::PluginProcessor()
 {
     Particle::initializeHannTable();
     
+    grainSizeParameter = apvts.getRawParameterValue ("grainSize");
+    grainFreqParameter = apvts.getRawParameterValue ("grainFreq");
+    attackParameter = apvts.getRawParameterValue ("attack");
+    sustainParameter = apvts.getRawParameterValue ("sustain");
+    releaseParameter = apvts.getRawParameterValue ("release");
+    masterGainParameter = apvts.getRawParameterValue ("masterGain");
+    interpolationParameter = apvts.getRawParameterValue ("interpolation");
+    multiCoreParameter = apvts.getRawParameterValue ("multiCore");
+    controlRateParameter = apvts.getRawParameterValue ("controlRate");
+    integratorParameter = apvts.getRawParameterValue ("integrator");
+    gravityFieldParameter = apvts.getRawParameterValue ("gravityField");
+    mutualGravityParameter = apvts.getRawParameterValue ("mutualGravity");
+    openingAngleParameter = apvts.getRawParameterValue ("openingAngle");
+    collisionParameter = apvts.getRawParameterValue ("collisions");
+    collisionRadiusParameter = apvts.getRawParameterValue ("collisionRadius");
+    
+    apvts.addParameterListener ("multiCore", this);
+    
     auto& state = apvts.state;
     if (!state.getChildWithName("MassPoints").isValid())
         state.appendChild(juce::ValueTree("MassPoints"), nullptr);
@@ -33,11 +52,16 @@ PluginProcessor::PluginProcessor()
         massPoints.push_back({ juce::Point<float>(200.0f, 200.0f), 4.0f });
         spawnPoints.push_back({ juce::Point<float>(100.0f, 300.0f), 0.0f });
         savePointsToTree();
+        publishPointScene();
     }
+    
+    reserveParticleStorage();
 }
 
 PluginProcessor::~PluginProcessor()
 {
+    apvts.removeParameterListener ("multiCore", this);
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -142,6 +166,83 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         }
     ));
     
+    // Grain interpolation quality (order matches GrainRenderer::Interpolation)
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "interpolation",
+        "Interpolation",
+        juce::StringArray { "Linear", "Hermite", "Sinc" },
+        1
+    ));
+    
+    // Samples between physics ticks (16 << index, see getControlInterval)
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "controlRate",
+        "Physics Control Rate",
+        juce::StringArray { "16 samples", "32 samples", "64 samples", "128 samples" },
+        1
+    ));
+    
+    // Orbit integrator (order matches ParticlePhysics::Integrator)
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "integrator",
+        "Integrator",
+        juce::StringArray { "Euler", "Velocity Verlet", "RK4" },
+        1
+    ));
+    
+    // Read gravity from a cached grid instead of summing every mass (faster, approximate near masses)
+    layout.add (std::make_unique<juce::AudioParameterBool> (
+        "gravityField",
+        "Approximate Gravity",
+        false,
+        juce::AudioParameterBoolAttributes().withAutomatable (false)
+    ));
+    
+    // Particles attracting each other, weighted by note velocity (0 = off)
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "mutualGravity",
+        "Mutual Gravity",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f),
+        0.0f,
+        juce::String(),
+        juce::AudioProcessorParameter::genericParameter,
+        [](float value, int) { return juce::String (juce::roundToInt (value * 100.0f)) + " %"; }
+    ));
+    
+    // Barnes-Hut opening angle: lower is more exact, higher is cheaper (0 sums every pair)
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "openingAngle",
+        "Mutual Gravity Opening Angle",
+        juce::NormalisableRange<float> (0.0f, 1.5f, 0.01f),
+        0.5f
+    ));
+    
+    // What particles do when they come within the collision radius (order matches ParticlePhysics::CollisionMode)
+    layout.add (std::make_unique<juce::AudioParameterChoice> (
+        "collisions",
+        "Collisions",
+        juce::StringArray { "Off", "Bounce", "Merge" },
+        0
+    ));
+    
+    layout.add (std::make_unique<juce::AudioParameterFloat> (
+        "collisionRadius",
+        "Collision Radius",
+        juce::NormalisableRange<float> (2.0f, 40.0f, 0.1f),
+        10.0f,
+        juce::String(),
+        juce::AudioProcessorParameter::genericParameter,
+        [](float value, int) { return juce::String (value, 1) + " px"; }
+    ));
+    
+    // Spread particles across the render pool's worker threads (a performance setting, not automatable)
+    layout.add (std::make_unique<juce::AudioParameterBool> (
+        "multiCore",
+        "Multi-Core Rendering",
+        false,
+        juce::AudioParameterBoolAttributes().withAutomatable (false)
+    ));
+    
     return layout;
 }
 
@@ -213,11 +314,76 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused (sampleRate, samplesPerBlock);
+    // Ticks per block at the fastest control rate, for the particles' tick history
+    samplesUntilControlTick = 0;
+    nextSpawnIndex = 0;
+    preparedBlockSize = samplesPerBlock;
+    preparedSampleRate = sampleRate;
+    smoothedGainCompensation = 1.0f;
+    maxControlTicksPerBlock = samplesPerBlock / minControlInterval + 1;
+    
+    prepareRenderWorkers();
+    
+    // Converts loaded files to the new rate in the background if it changed
+    sampleLoader.setTargetSampleRate (sampleRate);
+    
+    crossfadeLength = juce::roundToInt (sampleCrossfadeSeconds * sampleRate);
+    crossfadePosition = juce::jmin (crossfadePosition, crossfadeLength);
+    crossfadeIn.resize (static_cast<size_t>(samplesPerBlock));
+    crossfadeOut.resize (static_cast<size_t>(samplesPerBlock));
+    
+    prefetchWindows.reserve (static_cast<size_t>(SampleLoader::maxPrefetchWindows));
+    
+    reserveParticleStorage();
+    
+    gravityMasses.reserve (juce::jmax (massPoints.size(), static_cast<size_t>(16)));
+    
+    // Resolve the kernel dispatch now rather than on the first audio callback
+    GrainRenderer::getActiveInstructionSet();
 }
 
 void PluginProcessor::releaseResources()
 {
+    renderPool.release();
+    preparedBlockSize = 0;
+}
+
+void PluginProcessor::prepareRenderWorkers()
+{
+    // No threads at all unless multi-core rendering is on; run() renders on the audio
+    // thread when the pool is empty
+    if (multiCoreParameter->load() >= 0.5f && maxRenderWorkers > 0)
+        renderPool.prepare (maxRenderWorkers, preparedBlockSize, preparedSampleRate);
+    else
+        renderPool.release();
+    
+    // One scratch set per rendering thread; the audio thread is index 0
+    renderScratch.resize (static_cast<size_t>(renderPool.getNumWorkers() + 1));
+    
+    for (auto& scratch : renderScratch)
+    {
+        scratch.adsr.resize (static_cast<size_t>(preparedBlockSize));
+        scratch.fadingAdsr.resize (static_cast<size_t>(preparedBlockSize));
+        scratch.grainEnvelope.resize (static_cast<size_t>(preparedBlockSize));
+        scratch.tickGains.reserve (static_cast<size_t>(maxControlTicksPerBlock + 2));
+    }
+}
+
+void PluginProcessor::handleAsyncUpdate()
+{
+    // Not prepared: the next prepareToPlay picks the setting up
+    if (preparedBlockSize == 0)
+        return;
+    
+    const bool wantsWorkers = multiCoreParameter->load() >= 0.5f && maxRenderWorkers > 0;
+    if (wantsWorkers == (renderPool.getNumWorkers() > 0))
+        return;
+    
+    // Takes the callback lock so the pool and scratch never change under processBlock
+    const bool wasSuspended = isSuspended();
+    suspendProcessing (true);
+    prepareRenderWorkers();
+    suspendProcessing (wasSuspended);
 }
 
 //==============================================================================
@@ -238,6 +404,7 @@ void PluginProcessor::loadPointsFromTree()
             mp.massMultiplier = child.getProperty("mass", 4.0f);
             massPoints.push_back(mp);
         }
+        ++massConfigurationVersion;
     }
     
     auto spawnPointsTree = state.getChildWithName("SpawnPoints");
@@ -254,6 +421,8 @@ void PluginProcessor::loadPointsFromTree()
             spawnPoints.push_back(sp);
         }
     }
+    
+    publishPointScene();
 }
 
 void PluginProcessor::savePointsToTree()
@@ -283,6 +452,24 @@ void PluginProcessor::savePointsToTree()
     }
 }
 
+void PluginProcessor::publishPointScene()
+{
+    auto scene = std::make_unique<PointScene>();
+    scene->massPoints = massPoints;
+    scene->spawnPoints = spawnPoints;
+    scene->massConfigurationVersion = massConfigurationVersion;
+    
+    // With no points, notes play from the defaults (the GUI still shows none)
+    if (scene->spawnPoints.empty())
+        scene->spawnPoints.push_back ({ juce::Point<float>(200.0f, 200.0f), 0.0f });
+    
+    if (scene->massPoints.empty())
+        scene->massPoints.push_back ({ juce::Point<float>(200.0f, 200.0f), 2.0f });
+    
+    // The audio thread picks this up at its next block; scenes it's done with are freed here
+    pointScene.publish (std::move (scene));
+}
+
 //==============================================================================
 void PluginProcessor::updateMassPoint (int index, juce::Point<float> position, float massMultiplier)
 {
@@ -290,7 +477,9 @@ void PluginProcessor::updateMassPoint (int index, juce::Point<float> position, f
     {
         massPoints[static_cast<size_t>(index)].position = position;
         massPoints[static_cast<size_t>(index)].massMultiplier = massMultiplier;
+        ++massConfigurationVersion;
         savePointsToTree();
+        publishPointScene();
         updateHostDisplay();
     }
 }
@@ -301,7 +490,9 @@ void PluginProcessor::addMassPoint (juce::Point<float> position, float massMulti
     data.position = position;
     data.massMultiplier = massMultiplier;
     massPoints.push_back (data);
+    ++massConfigurationVersion;
     savePointsToTree();
+    publishPointScene();
     updateHostDisplay();
 }
 
@@ -310,7 +501,9 @@ void PluginProcessor::removeMassPoint (int index)
     if (index >= 0 && index < static_cast<int>(massPoints.size()))
     {
         massPoints.erase (massPoints.begin() + index);
+        ++massConfigurationVersion;
         savePointsToTree();
+        publishPointScene();
         updateHostDisplay();
     }
 }
@@ -322,6 +515,7 @@ void PluginProcessor::updateSpawnPoint (int index, juce::Point<float> position,
         spawnPoints[static_cast<size_t>(index)].position = position;
         spawnPoints[static_cast<size_t>(index)].momentumAngle = angle;
         savePointsToTree();
+        publishPointScene();
         updateHostDisplay();
     }
 }
@@ -333,6 +527,7 @@ void PluginProcessor::addSpawnPoint (juce::Point<float> position, float angle)
     data.momentumAngle = angle;
     spawnPoints.push_back (data);
     savePointsToTree();
+    publishPointScene();
     updateHostDisplay();
 }
 
@@ -342,6 +537,7 @@ void PluginProcessor::removeSpawnPoint (int index)
     {
         spawnPoints.erase (spawnPoints.begin() + index);
         savePointsToTree();
+        publishPointScene();
         updateHostDisplay();
     }
 }
@@ -353,52 +549,61 @@ void PluginProcessor::spawnParticle (juce::Point<float> position, juce::Point<fl
     const juce::ScopedLock lock (particlesLock);
     
     // Remove oldest particle if at limit
-    if (particles.size() >= maxParticles)
+    const int polyphony = juce::jmin (maxParticles, particlePool.getCapacity());
+    if (! particles.empty() && static_cast<int>(particles.size()) >= polyphony)
+        removeParticle (0);
+    
+    // After the removal above there is always a free particle
+    auto* particle = particlePool.acquire();
+    
+    if (particle == nullptr)
     {
-        auto* oldestParticle = particles[0];
-        int oldNote = oldestParticle->getMidiNoteNumber();
-        
-        if (activeNoteToParticles.count(oldNote) > 0)
-        {
-            auto& particleIndices = activeNoteToParticles[oldNote];
-            particleIndices.erase(std::remove(particleIndices.begin(), particleIndices.end(), 0), 
-                                 particleIndices.end());
-            if (particleIndices.empty())
-                activeNoteToParticles.erase(oldNote);
-        }
-        
-        particles.remove (0);
-        
-        // Shift all indices down
-        for (auto& pair : activeNoteToParticles)
-        {
-            for (auto& idx : pair.second)
-                if (idx > 0) idx--;
-        }
+        jassertfalse;
+        return;
     }
     
-    auto* particle = new Particle (position, velocity, canvasBounds, midiNoteNumber,
-                                   attackTime, sustainLevel, sustainLevelLinear, releaseTime, initialVelocity, pitchShift);
+    particle->respawn (position, velocity, canvasBounds, midiNoteNumber,
+                       attackTime, sustainLevel, sustainLevelLinear, releaseTime, initialVelocity, pitchShift);
+    
     particle->setBounceMode (bounceMode);
-    int newIndex = particles.size();
-    particles.add (particle);
+    particlePhysics.addBody (*particle);
+    particles.push_back (particle);
+    noteParticles.add (*particle);
+}
+
+void PluginProcessor::removeParticle (int index)
+{
+    auto* particle = particles[static_cast<size_t>(index)];
     
-    activeNoteToParticles[midiNoteNumber].push_back(newIndex);
+    noteParticles.remove (*particle);
+    particlePhysics.removeBody (particle->getPhysicsIndex());
+    particles.erase (particles.begin() + index);
+    particlePool.release (particle);
 }
 
-//==============================================================================
-void PluginProcessor::handleNoteOn (int noteNumber, float velocity, float pitchShift)
+void PluginProcessor::reserveParticleStorage()
 {
-    // Create defaults if needed
-    if (spawnPoints.size() == 0)
-        spawnPoints.push_back ({ juce::Point<float>(200.0f, 200.0f), 0.0f });
+    const juce::ScopedLock lock (particlesLock);
     
-    if (massPoints.size() == 0)
-        massPoints.push_back ({ juce::Point<float>(200.0f, 200.0f), 2.0f });
+    particlePool.reserve (maxParticles);
+    particlePool.forEachParticle ([this] (Particle& particle) { particle.reserveControlTicks (maxControlTicksPerBlock); });
     
-    float attackTime = apvts.getRawParameterValue("attack")->load();
-    float sustainLevelLinear = apvts.getRawParameterValue("sustain")->load();
-    float releaseTime = apvts.getRawParameterValue("release")->load();
+    particlePhysics.reserve (particlePool.getCapacity());
+    particles.reserve (static_cast<size_t>(particlePool.getCapacity()));
+}
+
+void PluginProcessor::setMaxParticles (int max)
+{
+    // The pool is resized in prepareToPlay; until then polyphony is capped at its current size
+    maxParticles = juce::jmax (1, max);
+}
+
+//==============================================================================
+void PluginProcessor::handleNoteOn (int noteNumber, float velocity, float pitchShift)
+{
+    float attackTime = attackParameter->load();
+    float sustainLevelLinear = sustainParameter->load();
+    float releaseTime = releaseParameter->load();
     
     // Convert linear sustain (0-1) to logarithmic amplitude (-60dB to 0dB)
     float sustainLevel;
@@ -412,12 +617,12 @@ void PluginProcessor::handleNoteOn (int noteNumber, float velocity, float pitchS
         sustainLevel = juce::Decibels::decibelsToGain(sustainDb);
     }
     
-    // Round-robin spawn point selection
-    static size_t nextSpawnIndex = 0;
-    size_t spawnIndex = nextSpawnIndex % spawnPoints.size();
-    nextSpawnIndex = (nextSpawnIndex + 1) % spawnPoints.size();
+    // Round-robin spawn point selection (a published scene always has at least one)
+    const auto& sceneSpawnPoints = blockScene->spawnPoints;
+    size_t spawnIndex = nextSpawnIndex % sceneSpawnPoints.size();
+    nextSpawnIndex = (nextSpawnIndex + 1) % sceneSpawnPoints.size();
     
-    auto& spawn = spawnPoints[spawnIndex];
+    const auto& spawn = sceneSpawnPoints[spawnIndex];
     juce::Point<float> spawnPos = spawn.position;
     
     float momentumMagnitude = 50.0f;
@@ -434,65 +639,93 @@ void PluginProcessor::handleNoteOff (int noteNumber)
 {
     const juce::ScopedLock lock (particlesLock);
     
-    if (activeNoteToParticles.count(noteNumber) > 0)
-    {
-        auto& particleIndices = activeNoteToParticles[noteNumber];
-        
-        for (int idx : particleIndices)
-        {
-            if (idx >= 0 && idx < particles.size())
-            {
-                particles[idx]->triggerRelease();
-            }
-        }
-    }
+    noteParticles.forEachParticle (noteNumber, [] (Particle& particle) { particle.triggerRelease(); });
 }
 
 //==============================================================================
-void PluginProcessor::updateParticleSimulation (double currentTime, int /*bufferSize*/)
+void PluginProcessor::updateParticleSimulation (int numSamples)
 {
-    if (lastUpdateTime == 0.0)
-        lastUpdateTime = currentTime;
-    
-    float deltaTime = static_cast<float>(currentTime - lastUpdateTime);
-    lastUpdateTime = currentTime;
-    deltaTime = juce::jmin (deltaTime, 0.1f);
+    // Physics ticks every controlInterval samples. The clock is the samples processed, not
+    // wall time, so offline and realtime renders match and block size doesn't change the sound.
+    // Each particle records where its ticks land so the renderer can interpolate between them.
+    const int controlInterval = getControlInterval();
+    samplesUntilControlTick = juce::jmin (samplesUntilControlTick, controlInterval);
     
     const juce::ScopedLock lock (particlesLock);
     
-    // Rotate spawn points for visual animation
-    for (auto& spawn : spawnPoints)
+    for (auto* particle : particles)
+        particle->beginControlBlock (numSamples, controlInterval);
+    
+    if (getSampleRate() <= 0.0)
+        return;
+    
+    const float deltaTime = static_cast<float>(controlInterval / getSampleRate());
+    
+    for (; samplesUntilControlTick < numSamples; samplesUntilControlTick += controlInterval)
     {
-        spawn.visualRotation += deltaTime * 0.5f;
-        if (spawn.visualRotation > juce::MathConstants<float>::twoPi)
-            spawn.visualRotation -= juce::MathConstants<float>::twoPi;
+        stepParticleSimulation (deltaTime);
+        
+        for (auto* particle : particles)
+            particle->recordControlTick (samplesUntilControlTick);
     }
     
-    for (int i = particles.size() - 1; i >= 0; --i)
+    samplesUntilControlTick -= numSamples;
+}
+
+void PluginProcessor::publishParticleSnapshot()
+{
+    // Copies only into storage sized at construction, so this never allocates
+    auto& snapshot = particleSnapshots.getWriteBuffer();
+    snapshot.numBodies = 0;
+    snapshot.numTrailPoints = 0;
+    snapshot.canvasBounds = canvasBounds;
+    
     {
-        auto* particle = particles[i];
-        particle->setCanvasBounds (canvasBounds);
+        const juce::ScopedLock lock (particlesLock);
         
-        // Calculate gravity from mass points
-        juce::Point<float> totalForce (0.0f, 0.0f);
+        snapshot.totalParticles = static_cast<int>(particles.size());
         
-        for (const auto& mass : massPoints)
-        {
-            juce::Point<float> particlePos = particle->getPosition();
-            juce::Point<float> direction = mass.position - particlePos;
-            float distance = direction.getDistanceFromOrigin();
-            
-            if (distance > 5.0f)
-            {
-                float effectiveGravity = gravityStrength * mass.massMultiplier;
-                float forceMagnitude = effectiveGravity / (distance * distance);
-                juce::Point<float> normalizedDirection = direction / distance;
-                totalForce += normalizedDirection * forceMagnitude;
-            }
-        }
-        
-        particle->applyForce (totalForce);
+        for (const auto* particle : particles)
+            particle->writeSnapshot (snapshot);
+    }
+    
+    particleSnapshots.publish();
+}
+
+int PluginProcessor::getControlInterval() const
+{
+    // 16, 32, 64 or 128 samples
+    return minControlInterval << juce::roundToInt (controlRateParameter->load());
+}
+
+void PluginProcessor::stepParticleSimulation (float deltaTime)
+{
+    for (auto* particle : particles)
+    {
+        particle->setCanvasBounds (canvasBounds);
         particle->update (deltaTime);
+    }
+    
+    // Gravity from mass points, integrated over the contiguous physics arrays
+    gravityMasses.clear();
+    for (const auto& mass : blockScene->massPoints)
+        gravityMasses.push_back ({ mass.position, gravityStrength * mass.massMultiplier });
+    
+    const bool useGravityField = gravityFieldParameter->load() >= 0.5f && updateGravityField();
+    particlePhysics.setGravityField (useGravityField ? &gravityField : nullptr, gravityStrength);
+    particlePhysics.setMutualGravity (mutualGravityParameter->load() * gravityStrength * mutualGravityScale,
+                                      openingAngleParameter->load());
+    
+    const auto integrator = static_cast<ParticlePhysics::Integrator> (juce::roundToInt (integratorParameter->load()));
+    particlePhysics.step (deltaTime, integrator, gravityMasses.data(), static_cast<int>(gravityMasses.size()));
+    
+    // Particles against each other, then against the canvas edges
+    const auto collisionMode = static_cast<ParticlePhysics::CollisionMode> (juce::roundToInt (collisionParameter->load()));
+    particlePhysics.resolveCollisions (collisionMode, collisionRadiusParameter->load(), canvasBounds);
+    
+    for (int i = static_cast<int>(particles.size()) - 1; i >= 0; --i)
+    {
+        auto* particle = particles[static_cast<size_t>(i)];
         
         if (bounceMode)
             particle->bounceOff (canvasBounds);
@@ -501,28 +734,31 @@ void PluginProcessor::updateParticleSimulation (double currentTime, int /*buffer
         
         // Remove finished particles
         if (particle->isFinished())
+            removeParticle (i);
+    }
+}
+
+bool PluginProcessor::updateGravityField()
+{
+    // Restart the build when the masses or canvas change; until it finishes, gravity is exact
+    const auto version = blockScene->massConfigurationVersion;
+    
+    if (version != gravityFieldVersion || gravityField.getBounds() != canvasBounds)
+    {
+        std::array<ParticlePhysics::Mass, GravityField::maxMasses> unitMasses;
+        const int numMasses = juce::jmin (static_cast<int>(blockScene->massPoints.size()), GravityField::maxMasses);
+        
+        for (int i = 0; i < numMasses; ++i)
         {
-            int noteNumber = particle->getMidiNoteNumber();
-            
-            if (activeNoteToParticles.count(noteNumber) > 0)
-            {
-                auto& particleIndices = activeNoteToParticles[noteNumber];
-                particleIndices.erase(std::remove(particleIndices.begin(), particleIndices.end(), i), 
-                                     particleIndices.end());
-                if (particleIndices.empty())
-                    activeNoteToParticles.erase(noteNumber);
-            }
-            
-            particles.remove (i);
-            
-            // Shift indices
-            for (auto& pair : activeNoteToParticles)
-            {
-                for (auto& idx : pair.second)
-                    if (idx > i) idx--;
-            }
+            const auto& mass = blockScene->massPoints[static_cast<size_t>(i)];
+            unitMasses[static_cast<size_t>(i)] = { mass.position, mass.massMultiplier };
         }
+        
+        gravityField.setMasses (unitMasses.data(), numMasses, canvasBounds);
+        gravityFieldVersion = version;
     }
+    
+    return gravityField.buildRows (gravityFieldRowsPerTick);
 }
 
 //==============================================================================
@@ -550,48 +786,58 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const int numSamples = buffer.getNumSamples();
 
     for (auto i = 0; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
     
-    // Merge pending MIDI from UI thread
-    {
-        const juce::ScopedLock lock (midiLock);
-        if (!pendingMidiMessages.isEmpty())
-        {
-            midiMessages.addEvents (pendingMidiMessages, 0, buffer.getNumSamples(), 0);
-            pendingMidiMessages.clear();
-        }
-    }
+    // The mass and spawn points as last published, held for the whole block
+    const RcuObject<PointScene>::ReadScope scene (pointScene);
+    blockScene = scene.get();
+    
+    // Scratch buffers, control ticks and crossfade gains are sized for the block size given
+    // to prepareToPlay, so a longer host block is split rather than growing them here
+    const int chunkSize = preparedBlockSize > 0 ? preparedBlockSize : numSamples;
+    
+    for (int startSample = 0; startSample < numSamples; startSample += chunkSize)
+        processChunk (buffer, startSample, juce::jmin (chunkSize, numSamples - startSample), midiMessages);
+}
 
-    // Process MIDI
+void PluginProcessor::processChunk (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                    const juce::MidiBuffer& midiMessages)
+{
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    
+    // MIDI from the UI that falls due in this chunk
+    const auto chunkEnd = samplePosition.load() + numSamples;
+    handleUiMidi (chunkEnd);
+    samplePosition.store (chunkEnd);
+    
+    // Host MIDI within the chunk (anything out of range goes to the first or last chunk)
+    const bool isFirstChunk = startSample == 0;
+    const bool isLastChunk = startSample + numSamples >= buffer.getNumSamples();
+    
     for (const auto metadata : midiMessages)
     {
-        auto message = metadata.getMessage();
+        const bool afterStart = isFirstChunk || metadata.samplePosition >= startSample;
+        const bool beforeEnd = isLastChunk || metadata.samplePosition < startSample + numSamples;
         
-        if (message.isNoteOn())
-        {
-            int midiNote = message.getNoteNumber();
-            float midiVelocity = message.getVelocity() / 127.0f;
-            float semitoneOffset = midiNote - 60;
-            float pitchShift = std::pow (2.0f, semitoneOffset / 12.0f);
-            handleNoteOn (midiNote, midiVelocity, pitchShift);
-        }
-        else if (message.isNoteOff())
-        {
-            handleNoteOff (message.getNoteNumber());
-        }
+        if (afterStart && beforeEnd)
+            handleMidiMessage (metadata.getMessage());
     }
     
-    double currentTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
-    updateParticleSimulation (currentTime, buffer.getNumSamples());
+    updateParticleSimulation (numSamples);
+    publishParticleSnapshot();
+    updateSampleCrossfade (numSamples);
 
-    if (!hasAudioFileLoaded() || audioFileBuffer.getNumSamples() == 0)
+    // Nothing to play until a file has loaded
+    if (blockRenderState.source.numSamples == 0 && blockRenderState.fadingSource.numSamples == 0)
         return;
     
-    float grainSizeMs = apvts.getRawParameterValue("grainSize")->load();
-    float grainFreq = apvts.getRawParameterValue("grainFreq")->load();
-    float masterGainDb = apvts.getRawParameterValue("masterGain")->load();
+    float grainSizeMs = grainSizeParameter->load();
+    float grainFreq = grainFreqParameter->load();
+    float masterGainDb = masterGainParameter->load();
+    auto interpolation = static_cast<GrainRenderer::Interpolation> (juce::roundToInt (interpolationParameter->load()));
     
     float masterGainLinear;
     if (masterGainDb <= -60.0f)
@@ -601,7 +847,7 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     
     const juce::ScopedLock lock (particlesLock);
     
-    if (particles.isEmpty())
+    if (particles.empty())
         return;
     
     // Automatic gain compensation for overlapping grains
@@ -616,184 +862,338 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         targetGainCompensation = juce::jmax(0.1f, targetGainCompensation);
     }
     
-    // Smooth gain changes to prevent clicks
-    static float smoothedGainCompensation = 1.0f;
+    // Smooth gain changes to prevent clicks, by as much per second whatever the block size
     float gainDifference = std::abs(targetGainCompensation - smoothedGainCompensation);
     float relativeDifference = gainDifference / juce::jmax(0.01f, smoothedGainCompensation);
     float timeConstant = 0.010f + (relativeDifference * 0.040f);
     timeConstant = juce::jmin(0.050f, timeConstant);
-    float smoothingCoefficient = 1.0f - static_cast<float>(std::exp(-2.2 / (static_cast<double>(timeConstant) * getSampleRate())));
+    float smoothingCoefficient = 1.0f - static_cast<float>(std::exp(-2.2 * numSamples / (static_cast<double>(timeConstant) * getSampleRate())));
     smoothedGainCompensation += smoothingCoefficient * (targetGainCompensation - smoothedGainCompensation);
     float gainCompensation = smoothedGainCompensation;
     
-    for (auto* particle : particles)
+    blockRenderState.interpolation = interpolation;
+    blockRenderState.grainSizeMs = grainSizeMs;
+    blockRenderState.grainFreq = grainFreq;
+    blockRenderState.masterGain = masterGainLinear;
+    blockRenderState.gainCompensation = gainCompensation;
+    blockRenderState.sampleRate = getSampleRate();
+    
+    float* leftChannel = totalNumOutputChannels >= 1 ? buffer.getWritePointer (0, startSample) : nullptr;
+    float* rightChannel = totalNumOutputChannels >= 2 ? buffer.getWritePointer (1, startSample) : nullptr;
+    
+    const int numParticles = static_cast<int>(particles.size());
+    
+    if (currentSample != nullptr && currentSample->isStreamed())
+        updatePrefetchWindows();
+    
+    if (multiCoreParameter->load() >= 0.5f)
     {
-        particle->updateSampleRate (getSampleRate());
-        particle->setGrainParameters (grainSizeMs, 0.0f, 0.0f);
-        
-        if (particle->shouldTriggerNewGrain (getSampleRate(), grainFreq))
-            particle->triggerNewGrain (audioFileBuffer.getNumSamples());
+        renderPool.run (*this, numParticles, leftChannel, rightChannel, numSamples);
+    }
+    else
+    {
+        for (int i = 0; i < numParticles; ++i)
+            renderItem (i, 0, leftChannel, rightChannel, numSamples);
+    }
+    
+    // Store output for continuity checking
+    if (leftChannel != nullptr)
+        lastBufferOutputLeft = leftChannel[numSamples - 1];
+    
+    if (rightChannel != nullptr)
+        lastBufferOutputRight = rightChannel[numSamples - 1];
+}
+
+void PluginProcessor::updateSampleCrossfade (int numSamples)
+{
+    // Hand the faded-out sample back to the loader to free (retried until it's collected)
+    if (crossfadePosition >= crossfadeLength && fadingSample != nullptr && sampleLoader.retire (fadingSample))
+        fadingSample = nullptr;
+    
+    // One crossfade at a time: a newer file waits in the loader until this one's done
+    if (crossfadePosition >= crossfadeLength && fadingSample == nullptr)
+    {
+        auto* incoming = sampleLoader.takeLoaded();
         
-        auto& grains = particle->getActiveGrains();
+        // The same file reloaded, which the shared cache hands back as the sample already
+        // playing: nothing to fade, just give the extra reference back (retried above if need be)
+        if (incoming != nullptr && incoming == currentSample)
+        {
+            if (! sampleLoader.retire (incoming))
+                fadingSample = incoming;
+        }
+        else if (incoming != nullptr)
+        {
+            fadingSample = currentSample;
+            currentSample = incoming;
+            crossfadePosition = 0;
+            crossfadeIsEqualGain = fadingSample != nullptr && fadingSample->file == currentSample->file;
+        }
+    }
+    
+    // Only differs from 1 until the loader has converted a sample to the host rate
+    auto getSourceRateRatio = [hostRate = getSampleRate()] (const LoadedSample* sample)
+    {
+        if (sample == nullptr || hostRate <= 0.0 || sample->renderSampleRate <= 0.0)
+            return 1.0f;
         
-        for (auto& grain : grains)
-            grain.samplesRenderedThisBuffer = 0;
+        return static_cast<float>(sample->renderSampleRate / hostRate);
+    };
+    
+    blockRenderState.source = currentSample != nullptr ? currentSample->getSource() : GrainRenderer::Source {};
+    blockRenderState.sourceRateRatio = getSourceRateRatio (currentSample);
+    
+    if (crossfadePosition >= crossfadeLength)
+    {
+        blockRenderState.fadingSource = {};
+        blockRenderState.crossfadeIn = nullptr;
+        blockRenderState.crossfadeOut = nullptr;
+        return;
+    }
+    
+    blockRenderState.fadingSource = fadingSample != nullptr ? fadingSample->getSource() : GrainRenderer::Source {};
+    blockRenderState.fadingSourceRateRatio = getSourceRateRatio (fadingSample);
+    
+    // Equal power between different files, whose grains are uncorrelated. A file reconverted
+    // to a new rate sounds almost the same either side, so it gets equal gain instead.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float progress = juce::jmin (1.0f, static_cast<float>(crossfadePosition + i) / static_cast<float>(crossfadeLength));
         
-        if (grains.empty())
+        if (crossfadeIsEqualGain)
+        {
+            crossfadeIn[static_cast<size_t>(i)] = progress;
+            crossfadeOut[static_cast<size_t>(i)] = 1.0f - progress;
+        }
+        else
         {
-            particle->updateGrains (buffer.getNumSamples());
-            continue;
+            crossfadeIn[static_cast<size_t>(i)] = std::sin (progress * juce::MathConstants<float>::halfPi);
+            crossfadeOut[static_cast<size_t>(i)] = std::cos (progress * juce::MathConstants<float>::halfPi);
         }
+    }
+    
+    crossfadePosition = juce::jmin (crossfadeLength, crossfadePosition + numSamples);
+    blockRenderState.crossfadeIn = crossfadeIn.data();
+    blockRenderState.crossfadeOut = crossfadeOut.data();
+}
+
+void PluginProcessor::updatePrefetchWindows()
+{
+    // A grain reads from wherever its particle is when it starts, so follow each particle's
+    // path a little way ahead and ask for the stretches its next few grains will read
+    const auto& state = blockRenderState;
+    const float horizon = static_cast<float>(prefetchHorizonSeconds);
+    const int grainsAhead = juce::jlimit (1, maxPrefetchGrainsPerParticle, static_cast<int>(std::ceil (state.grainFreq * horizon)));
+    
+    prefetchWindows.clear();
+    
+    for (auto* particle : particles)
+    {
+        const auto position = particle->getPosition();
+        const auto velocity = particle->getVelocity();
+        const int readLength = static_cast<int>(std::ceil (static_cast<float>(particle->getTotalGrainSamples()) * particle->getPitchShift()))
+                             + GrainRenderer::guardSamples;
         
-        // Pre-calculate ADSR for entire buffer
-        std::vector<float> adsrAmplitudes(static_cast<size_t>(buffer.getNumSamples()));
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        for (int grain = 0; grain < grainsAhead && prefetchWindows.size() < prefetchWindows.capacity(); ++grain)
         {
-            particle->updateADSRSample (getSampleRate());
-            adsrAmplitudes[static_cast<size_t>(i)] = particle->getADSRAmplitudeSmoothed();
+            const float time = horizon * static_cast<float>(grain) / static_cast<float>(grainsAhead);
+            const int start = particle->calculateGrainStartPosition (state.source.numSamples, position + velocity * time);
+            prefetchWindows.push_back ({ start, start + readLength });
         }
+    }
+    
+    sampleLoader.setPrefetchWindows (currentSample, prefetchWindows.data(), static_cast<int>(prefetchWindows.size()));
+}
+
+void PluginProcessor::renderItem (int item, int threadIndex, float* leftChannel, float* rightChannel, int numSamples)
+{
+    auto* particle = particles[static_cast<size_t>(item)];
+    auto& scratch = renderScratch[static_cast<size_t>(threadIndex)];
+    const auto& state = blockRenderState;
+    
+    particle->updateSampleRate (state.sampleRate);
+    particle->setGrainParameters (state.grainSizeMs, 0.0f, 0.0f);
+    
+    particle->scheduleGrains (state.sampleRate, state.grainFreq, numSamples, state.source.numSamples);
+    
+    auto& grains = particle->getActiveGrains();
+    
+    for (auto& grain : grains)
+        grain.samplesRenderedThisBuffer = 0;
+    
+    if (grains.empty())
+    {
+        particle->updateGrains (numSamples);
+        return;
+    }
+    
+    // Pre-calculate ADSR for entire buffer
+    particle->renderADSRBlock (scratch.adsr.data(), numSamples);
+    
+    // Mid-crossfade, every grain plays from both samples under complementary gains
+    const bool crossfading = state.crossfadeIn != nullptr;
+    
+    if (crossfading)
+    {
+        juce::FloatVectorOperations::multiply (scratch.fadingAdsr.data(), scratch.adsr.data(), state.crossfadeOut, numSamples);
+        juce::FloatVectorOperations::multiply (scratch.adsr.data(), state.crossfadeIn, numSamples);
+    }
+    
+    // Pan and gain at each control tick. Over the control interval after a tick they ramp
+    // from the previous tick's values to its own, so grains render in one segment per tick.
+    const auto& ticks = particle->getControlTicks();
+    const int controlInterval = particle->getControlInterval();
+    
+    scratch.tickGains.clear();
+    for (const auto& tick : ticks)
+    {
+        float panAngle = (tick.edgeFade.pan + 1.0f) * juce::MathConstants<float>::pi / 4.0f;
+        
+        GrainRenderer::Gains gains;
+        gains.amplitude = state.masterGain * tick.edgeFade.amplitude * particle->getInitialVelocityMultiplier() * state.gainCompensation;
+        gains.leftPan = std::cos (panAngle);
+        gains.rightPan = std::sin (panAngle);
+        scratch.tickGains.push_back (gains);
+    }
+    
+    auto lerpGains = [] (const GrainRenderer::Gains& from, const GrainRenderer::Gains& to, float progress)
+    {
+        return GrainRenderer::Gains { from.amplitude + (to.amplitude - from.amplitude) * progress,
+                                      from.leftPan + (to.leftPan - from.leftPan) * progress,
+                                      from.rightPan + (to.rightPan - from.rightPan) * progress };
+    };
+    
+    // The tick whose ramp covers the first sample of the block
+    size_t tickIndex = 1;
+    while (tickIndex + 1 < ticks.size() && ticks[tickIndex + 1].offset <= 0)
+        ++tickIndex;
+    
+    const int totalGrainSamples = particle->getTotalGrainSamples();
+    
+    for (int segmentStart = 0; segmentStart < numSamples; ++tickIndex)
+    {
+        const int segmentEnd = tickIndex + 1 < ticks.size() ? ticks[tickIndex + 1].offset : numSamples;
+        const int rampEnd = ticks[tickIndex].offset + controlInterval;
+        const auto& targetGains = scratch.tickGains[tickIndex];
         
         for (auto& grain : grains)
         {
-            int grainStartSample = grain.startSample;
-            int grainPosition = grain.playbackPosition;
-            int totalGrainSamples = particle->getTotalGrainSamples();
+            // Grains triggered this block start part way through it
+            const int grainStart = juce::jmax (segmentStart, grain.blockOffset);
+            const int grainPosition = grain.playbackPosition + grain.samplesRenderedThisBuffer;
             
-            int samplesToRender = juce::jmin (buffer.getNumSamples(), 
-                                              totalGrainSamples - grainPosition);
+            int samplesToRender = juce::jmin (segmentEnd - grainStart, totalGrainSamples - grainPosition);
             
             if (samplesToRender <= 0)
                 continue;
             
-            auto edgeFade = particle->getEdgeFade();
-            
-            float constantAmplitude = masterGainLinear;
-            constantAmplitude *= edgeFade.amplitude;
-            constantAmplitude *= particle->getInitialVelocityMultiplier();
-            constantAmplitude *= gainCompensation;
+            // Grain window (Hann fades)
+            particle->renderGrainEnvelope (grain, grainPosition, scratch.grainEnvelope.data(), samplesToRender);
             
-            float pitchShift = particle->getPitchShift();
+            // A new grain joins the ramp where it currently is
+            const int rampSamples = juce::jmax (1, rampEnd - grainStart);
+            const auto startGains = grain.hasRendered
+                                  ? grain.lastGains
+                                  : lerpGains (scratch.tickGains[tickIndex - 1], targetGains,
+                                               juce::jlimit (0.0f, 1.0f, static_cast<float>(grainStart - ticks[tickIndex].offset) / static_cast<float>(controlInterval)));
             
-            float panAngle = (edgeFade.pan + 1.0f) * juce::MathConstants<float>::pi / 4.0f;
-            float leftPanGain = std::cos (panAngle);
-            float rightPanGain = std::sin (panAngle);
+            // Folds any remaining file/host rate mismatch into the grain's pitch
+            const float pitchShift = particle->getPitchShift() * state.sourceRateRatio;
             
-            float channelMult = 1.0f / static_cast<float>(audioFileBuffer.getNumChannels());
-            int bufferLength = audioFileBuffer.getNumSamples();
+            GrainRenderer::GrainBlock grainBlock;
+            grainBlock.startSample = static_cast<float>(grain.startSample) + grain.subSampleDelay * pitchShift;
+            grainBlock.playbackPosition = grainPosition;
+            grainBlock.pitchShift = pitchShift;
+            grainBlock.interpolation = state.interpolation;
+            grainBlock.grainEnvelope = scratch.grainEnvelope.data();
+            grainBlock.adsrEnvelope = scratch.adsr.data() + grainStart;
+            grainBlock.start = startGains;
+            grainBlock.end = targetGains;
+            grainBlock.rampSamples = rampSamples;
+            grainBlock.numSamples = samplesToRender;
             
-            const float** sourceChannelPointers = new const float*[static_cast<size_t>(audioFileBuffer.getNumChannels())];
-            for (int ch = 0; ch < audioFileBuffer.getNumChannels(); ++ch)
-                sourceChannelPointers[ch] = audioFileBuffer.getReadPointer (ch);
+            GrainRenderer::render (state.source, grainBlock, leftChannel + grainStart,
+                                   rightChannel != nullptr ? rightChannel + grainStart : nullptr);
             
-            float* leftChannel = totalNumOutputChannels >= 1 ? buffer.getWritePointer (0) : nullptr;
-            float* rightChannel = totalNumOutputChannels >= 2 ? buffer.getWritePointer (1) : nullptr;
-            
-            for (int i = 0; i < samplesToRender; ++i)
+            if (crossfading)
             {
-                float sourcePosition = grainStartSample + ((grainPosition + i) * pitchShift);
-                
-                // Wrap around buffer boundaries
-                while (sourcePosition >= bufferLength)
-                    sourcePosition -= bufferLength;
-                while (sourcePosition < 0)
-                    sourcePosition += bufferLength;
-                
-                int sourceSample = static_cast<int>(sourcePosition);
-                float fraction = sourcePosition - sourceSample;
-                fraction = juce::jlimit(0.0f, 1.0f, fraction);
-                
-                // Cubic interpolation indices with wrapping
-                auto wrapIndex = [bufferLength](int index) -> int {
-                    while (index < 0) index += bufferLength;
-                    while (index >= bufferLength) index -= bufferLength;
-                    return index;
-                };
-                
-                int s0 = wrapIndex(sourceSample - 1);
-                int s1 = wrapIndex(sourceSample);
-                int s2 = wrapIndex(sourceSample + 1);
-                int s3 = wrapIndex(sourceSample + 2);
-                
-                float y0 = 0.0f, y1 = 0.0f, y2 = 0.0f, y3 = 0.0f;
-                for (int channel = 0; channel < audioFileBuffer.getNumChannels(); ++channel)
-                {
-                    y0 += sourceChannelPointers[channel][s0];
-                    y1 += sourceChannelPointers[channel][s1];
-                    y2 += sourceChannelPointers[channel][s2];
-                    y3 += sourceChannelPointers[channel][s3];
-                }
-                y0 *= channelMult;
-                y1 *= channelMult;
-                y2 *= channelMult;
-                y3 *= channelMult;
-                
-                // Cubic Hermite interpolation
-                float c0 = y1;
-                float c1 = 0.5f * (y2 - y0);
-                float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
-                float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
-                float audioSample = ((c3 * fraction + c2) * fraction + c1) * fraction + c0;
-                
-                // Clamp to prevent cubic overshoot
-                float minSample = juce::jmin(y0, y1, y2, y3);
-                float maxSample = juce::jmax(y0, y1, y2, y3);
-                audioSample = juce::jlimit(minSample, maxSample, audioSample);
-                
-                // Flush denormals
-                if (std::abs(audioSample) < 1e-6f)
-                    audioSample = 0.0f;
-                
-                // Calculate grain amplitude (Hann window)
-                Grain currentGrain = grain;
-                currentGrain.playbackPosition = grainPosition + i;
-                float grainAmplitude = particle->getGrainAmplitude (currentGrain);
-                
-                float adsrAmplitude = adsrAmplitudes[static_cast<size_t>(i)];
-                float totalAmplitude = grainAmplitude * constantAmplitude * adsrAmplitude;
-                
-                float leftGain = leftPanGain * totalAmplitude;
-                float rightGain = rightPanGain * totalAmplitude;
-                
-                float leftSample = audioSample * leftGain;
-                float rightSample = audioSample * rightGain;
-                
-                // Soft clip to prevent harsh digital clipping
-                if (std::abs(leftSample) > 0.9f)
-                    leftSample = std::tanh(leftSample * 0.9f) / 0.9f;
-                if (std::abs(rightSample) > 0.9f)
-                    rightSample = std::tanh(rightSample * 0.9f) / 0.9f;
-                
-                if (leftChannel)
-                    leftChannel[i] += leftSample;
-                if (rightChannel)
-                    rightChannel[i] += rightSample;
+                const float fadingPitchShift = particle->getPitchShift() * state.fadingSourceRateRatio;
+                grainBlock.startSample = static_cast<float>(grain.startSample) + grain.subSampleDelay * fadingPitchShift;
+                grainBlock.pitchShift = fadingPitchShift;
+                grainBlock.adsrEnvelope = scratch.fadingAdsr.data() + grainStart;
+                GrainRenderer::render (state.fadingSource, grainBlock, leftChannel + grainStart,
+                                       rightChannel != nullptr ? rightChannel + grainStart : nullptr);
             }
             
-            grain.samplesRenderedThisBuffer = samplesToRender;
-            delete[] sourceChannelPointers;
+            grain.samplesRenderedThisBuffer += samplesToRender;
+            grain.lastGains = lerpGains (startGains, targetGains, juce::jmin (1.0f, static_cast<float>(samplesToRender) / static_cast<float>(rampSamples)));
+            grain.hasRendered = true;
         }
         
-        particle->updateGrains (buffer.getNumSamples());
+        segmentStart = segmentEnd;
     }
     
-    // Store output for continuity checking
-    if (totalNumOutputChannels >= 1)
+    particle->updateGrains (numSamples);
+}
+
+void PluginProcessor::handleMidiMessage (const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        int midiNote = message.getNoteNumber();
+        float midiVelocity = message.getVelocity() / 127.0f;
+        float semitoneOffset = midiNote - 60;
+        float pitchShift = std::pow (2.0f, semitoneOffset / 12.0f);
+        handleNoteOn (midiNote, midiVelocity, pitchShift);
+    }
+    else if (message.isNoteOff())
     {
-        float* leftChannel = buffer.getWritePointer(0);
-        lastBufferOutputLeft = leftChannel[buffer.getNumSamples() - 1];
+        handleNoteOff (message.getNoteNumber());
+    }
+}
+
+void PluginProcessor::handleUiMidi (juce::int64 blockEnd)
+{
+    // Take everything queued, so an event scheduled far ahead can't hold up later ones.
+    // Ties keep the order they were queued in.
+    while (numPendingUiMidi < static_cast<int>(pendingUiMidi.size()))
+    {
+        const auto* event = uiMidiQueue.front();
         
-        if (totalNumOutputChannels >= 2)
-        {
-            float* rightChannel = buffer.getWritePointer(1);
-            lastBufferOutputRight = rightChannel[buffer.getNumSamples() - 1];
-        }
+        if (event == nullptr)
+            break;
+        
+        const auto pendingEnd = pendingUiMidi.begin() + numPendingUiMidi;
+        const auto insertAt = std::upper_bound (pendingUiMidi.begin(), pendingEnd, event->samplePosition,
+                                                [] (juce::int64 position, const MidiEventQueue::Event& pending) { return position < pending.samplePosition; });
+        
+        std::move_backward (insertAt, pendingEnd, pendingEnd + 1);
+        *insertAt = *event;
+        ++numPendingUiMidi;
+        uiMidiQueue.pop();
     }
+    
+    int numDue = 0;
+    
+    while (numDue < numPendingUiMidi && pendingUiMidi[static_cast<size_t>(numDue)].samplePosition < blockEnd)
+        handleMidiMessage (pendingUiMidi[static_cast<size_t>(numDue++)].toMessage());
+    
+    std::move (pendingUiMidi.begin() + numDue, pendingUiMidi.begin() + numPendingUiMidi, pendingUiMidi.begin());
+    numPendingUiMidi -= numDue;
 }
 
-void PluginProcessor::injectMidiMessage (const juce::MidiMessage& message)
+bool PluginProcessor::injectMidiMessage (const juce::MidiMessage& message)
 {
-    const juce::ScopedLock lock (midiLock);
-    pendingMidiMessages.addEvent (message, 0);
+    return scheduleMidiMessage (message, 0);
+}
+
+bool PluginProcessor::scheduleMidiMessage (const juce::MidiMessage& message, juce::int64 position)
+{
+    if (uiMidiQueue.push (message, position))
+        return true;
+    
+    LOG_WARNING("UI MIDI queue full, dropped " + message.getDescription());
+    return false;
 }
 
 //==============================================================================
@@ -889,45 +1289,18 @@ void PluginProcessor::loadAudioFile (const juce::File& file)
         return;
     }
     
-    LOG_INFO("Loading audio file: " + file.getFullPathName());
-    
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    
-    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
-    
-    if (reader != nullptr)
-    {
-        loadedAudioFile = file;
-        audioFileSampleRate = reader->sampleRate;
-        
-        audioFileBuffer.setSize (static_cast<int>(reader->numChannels),
-                                 static_cast<int>(reader->lengthInSamples));
-        
-        reader->read (&audioFileBuffer,
-                      0,
-                      static_cast<int>(reader->lengthInSamples),
-                      0,
-                      true,
-                      true);
-        
-        LOG_INFO("Audio file loaded - " + juce::String(reader->numChannels) + " ch, " +
-                 juce::String(reader->sampleRate) + " Hz, " +
-                 juce::String(reader->lengthInSamples / reader->sampleRate, 2) + "s");
-    }
-    else
-    {
-        LOG_WARNING("Failed to create audio reader for: " + file.getFullPathName());
-        loadedAudioFile = juce::File();
-        audioFileBuffer.setSize (0, 0);
-        audioFileSampleRate = 0.0;
-    }
+    // Returns straight away; the current file keeps playing until the new one is decoded
+    loadedAudioFile = file;
+    sampleLoader.load (file);
 }
 
 //==============================================================================
 
-void PluginProcessor::parameterChanged (const juce::String& /*parameterID*/, float /*newValue*/)
+void PluginProcessor::parameterChanged (const juce::String& parameterID, float /*newValue*/)
 {
+    // May be called on the audio thread by host automation, so the pool is changed later
+    if (parameterID == "multiCore")
+        triggerAsyncUpdate();
 }
 
 //==============================================================================
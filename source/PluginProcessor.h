@@ -1,8 +1,15 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <map>
+#include <array>
 #include "Particle.h"
+#include "GrainRenderPool.h"
+#include "GravityField.h"
+#include "ParticlePool.h"
+#include "MidiEventQueue.h"
+#include "TripleBuffer.h"
+#include "RcuObject.h"
+#include "SampleLoader.h"
 
 #if (MSVC)
 #include "ipps.h"
@@ -20,11 +27,21 @@ struct SpawnPointData
 {
     juce::Point<float> position;
     float momentumAngle = 0.0f;
-    float visualRotation = 0.0f;
+};
+
+// The mass and spawn points as the audio thread sees them. Built whole on the message
+// thread and never changed once published.
+struct PointScene
+{
+    std::vector<MassPointData> massPoints;
+    std::vector<SpawnPointData> spawnPoints;
+    uint32_t massConfigurationVersion = 0;   // See PluginProcessor::getMassConfigurationVersion
 };
 
 class PluginProcessor : public juce::AudioProcessor,
-                         public juce::AudioProcessorValueTreeState::Listener
+                         public juce::AudioProcessorValueTreeState::Listener,
+                         private juce::AsyncUpdater,
+                         private GrainRenderPool::Job
 {
 public:
     PluginProcessor();
@@ -56,19 +73,38 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    // Message thread. Decodes the file in the background; the audio thread crossfades to
+    // it once it's ready.
     void loadAudioFile (const juce::File& file);
+    // Blocks until a requested file has finished loading (for offline use and tests)
+    bool waitForAudioFile (int timeoutMs = 10000) { return sampleLoader.waitUntilIdle (timeoutMs); }
+    // The file last requested, which may still be loading
     juce::File getLoadedAudioFile() const { return loadedAudioFile; }
-    bool hasAudioFileLoaded() const { return loadedAudioFile.existsAsFile(); }
-    const juce::AudioBuffer<float>* getAudioBuffer() const { return &audioFileBuffer; }
+    bool hasAudioFileLoaded() const { return getLoadedSample() != nullptr; }
+    // Message thread. The most recently decoded file, shared read-only with the audio thread.
+    std::shared_ptr<const LoadedSample> getLoadedSample() const { return sampleLoader.getLatest(); }
     
     void setCanvas (Canvas* canvasPtr) { canvas = canvasPtr; }
-    void injectMidiMessage (const juce::MidiMessage& message);
+    
+    // Message thread only. Plays the message at the start of the next block, or in the block
+    // containing samplePosition (see getSamplePosition). Events may be queued in any order.
+    // Returns false if the queue is full.
+    bool injectMidiMessage (const juce::MidiMessage& message);
+    bool scheduleMidiMessage (const juce::MidiMessage& message, juce::int64 samplePosition);
+    // Samples processed so far; the start of the next block
+    juce::int64 getSamplePosition() const { return samplePosition.load(); }
     
     juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
     
-    juce::OwnedArray<Particle>* getParticles() { return &particles; }
+    std::vector<Particle*>* getParticles() { return &particles; }
     juce::CriticalSection& getParticlesLock() { return particlesLock; }
     
+    // Message thread only. The particles as of the latest processed block, read without
+    // locking. Valid until the next call.
+    const ParticleSnapshot& readParticleSnapshot() { return particleSnapshots.read(); }
+    
+    // The mass/spawn point functions below are message thread only. Each change is
+    // published to the audio thread as a new PointScene.
     void loadPointsFromTree();
     void savePointsToTree();
     
@@ -76,6 +112,8 @@ public:
     void addMassPoint (juce::Point<float> position, float massMultiplier);
     void removeMassPoint (int index);
     const std::vector<MassPointData>& getMassPoints() const { return massPoints; }
+    // Bumped whenever the mass points change, so cached gravity fields know to rebuild
+    uint32_t getMassConfigurationVersion() const { return massConfigurationVersion; }
     
     void updateSpawnPoint (int index, juce::Point<float> position, float angle);
     void addSpawnPoint (juce::Point<float> position, float angle);
@@ -89,10 +127,15 @@ public:
     void setGravityStrength (float strength) { gravityStrength = strength; }
     void setCanvasBounds (juce::Rectangle<float> bounds) { canvasBounds = bounds; }
     void setParticleLifespan (float lifespan) { particleLifespan = lifespan; }
-    void setMaxParticles (int max) { maxParticles = max; }
+    // Maximum polyphony; the particle pool is sized from it in prepareToPlay
+    void setMaxParticles (int max);
     void setBounceMode (bool enabled);
     bool getBounceMode() const { return bounceMode; }
     
+    // Worker threads for multi-core rendering, started only while the multiCore parameter
+    // is on; takes effect on the next prepareToPlay
+    void setMaxRenderWorkers (int numWorkers) { maxRenderWorkers = juce::jmax (0, numWorkers); }
+    
     void parameterChanged (const juce::String& parameterID, float newValue) override;
 
 private:
@@ -102,37 +145,155 @@ private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     juce::File loadedAudioFile;
-    juce::AudioBuffer<float> audioFileBuffer;
-    double audioFileSampleRate = 0.0;
+    SampleLoader sampleLoader;
+    
+    // Audio thread: the sample the grains read from and, during a crossfade, the one
+    // being faded out (nullptr fades in from silence). Both are owned by sampleLoader.
+    const LoadedSample* currentSample = nullptr;
+    const LoadedSample* fadingSample = nullptr;
+    static constexpr double sampleCrossfadeSeconds = 0.05;
+    int crossfadeLength = 0;
+    int crossfadePosition = 0;   // Samples into the crossfade; reaching crossfadeLength ends it
+    bool crossfadeIsEqualGain = false;   // Between two conversions of the same file, which play alike
+    std::vector<float> crossfadeIn, crossfadeOut;   // This block's gains, sized in prepareToPlay
+    
+    // Streamed samples: where each particle's next grains will read, for the loader to page in
+    static constexpr double prefetchHorizonSeconds = 0.25;
+    static constexpr int maxPrefetchGrainsPerParticle = 8;
+    std::vector<juce::Range<int>> prefetchWindows;   // Reserved in prepareToPlay
     
     Canvas* canvas = nullptr;
     
-    juce::MidiBuffer pendingMidiMessages;
-    juce::CriticalSection midiLock;
+    MidiEventQueue uiMidiQueue;   // From the on-screen keyboard and canvas
+    
+    // UI events taken off uiMidiQueue that aren't due yet, in time order (audio thread only)
+    std::array<MidiEventQueue::Event, MidiEventQueue::capacity> pendingUiMidi;
+    int numPendingUiMidi = 0;
+    std::atomic<juce::int64> samplePosition { 0 };
     
-    juce::OwnedArray<Particle> particles;
+    // The audio thread never allocates particles: particlePool owns them all (sized from
+    // maxParticles) and particles holds the live ones in spawn order
+    ParticlePool particlePool;
+    std::vector<Particle*> particles;
+    ParticlePhysics particlePhysics;   // Motion state of the live particles
+    std::vector<ParticlePhysics::Mass> gravityMasses;   // massPoints as the physics sees them, rebuilt each tick
     juce::CriticalSection particlesLock;
     
-    // Maps MIDI note -> particle indices for ADSR release
-    std::map<int, std::vector<int>> activeNoteToParticles;
+    // Live particles by MIDI note, for ADSR release
+    NoteParticleIndex noteParticles;
     
+    // Handed from the audio thread to the GUI after every block (see publishParticleSnapshot)
+    TripleBuffer<ParticleSnapshot> particleSnapshots;
+    
+    // Cached so the audio thread doesn't look parameters up by name
+    std::atomic<float>* grainSizeParameter = nullptr;
+    std::atomic<float>* grainFreqParameter = nullptr;
+    std::atomic<float>* attackParameter = nullptr;
+    std::atomic<float>* sustainParameter = nullptr;
+    std::atomic<float>* releaseParameter = nullptr;
+    std::atomic<float>* masterGainParameter = nullptr;
+    std::atomic<float>* interpolationParameter = nullptr;
+    std::atomic<float>* multiCoreParameter = nullptr;
+    std::atomic<float>* controlRateParameter = nullptr;
+    std::atomic<float>* integratorParameter = nullptr;
+    std::atomic<float>* gravityFieldParameter = nullptr;
+    std::atomic<float>* mutualGravityParameter = nullptr;
+    std::atomic<float>* openingAngleParameter = nullptr;
+    std::atomic<float>* collisionParameter = nullptr;
+    std::atomic<float>* collisionRadiusParameter = nullptr;
+    
+    // The message thread's working copy of the points, published through pointScene
     std::vector<MassPointData> massPoints;
+    uint32_t massConfigurationVersion = 1;
     std::vector<SpawnPointData> spawnPoints;
+    RcuObject<PointScene> pointScene;
+    const PointScene* blockScene = nullptr;   // Audio thread: the scene for the current block
     bool stateHasBeenRestored = false;
     
     float gravityStrength = 50000.0f;
+    // At full mutual gravity, a full-velocity particle pulls like a quarter-strength mass point
+    static constexpr float mutualGravityScale = 0.25f;
     juce::Rectangle<float> canvasBounds {0, 0, 400, 400};
     float particleLifespan = 30.0f;
     int maxParticles = 8;
     bool bounceMode = false;
     
-    double lastUpdateTime = 0.0;
+    // Physics ticks on the sample clock at the control rate (see updateParticleSimulation)
+    static constexpr int minControlInterval = 16;
+    int samplesUntilControlTick = 0;
+    int maxControlTicksPerBlock = 64;
+    
+    // Round-robin over the spawn points, restarted with the sample clock so every render matches
+    size_t nextSpawnIndex = 0;
+    
+    // Per-block storage is sized for this; longer host blocks are processed in pieces
+    int preparedBlockSize = 0;
+    
+    // Approximate gravity: the mass points' field cached on a grid, rebuilt a slice per tick
+    static constexpr int gravityFieldRowsPerTick = 16;
+    GravityField gravityField;
+    uint32_t gravityFieldVersion = 0;
+    
+    // Overlapping grain compensation, eased towards 1/sqrt(active grains)
+    float smoothedGainCompensation = 1.0f;
     
     // Prevents clicks at buffer boundaries
     float lastBufferOutputLeft = 0.0f;
     float lastBufferOutputRight = 0.0f;
     
+    // Per-block scratch for the grain renderer, one per rendering thread, sized in prepareToPlay
+    struct RenderScratch
+    {
+        std::vector<float> adsr;
+        std::vector<float> fadingAdsr;   // adsr for the sample being crossfaded out
+        std::vector<float> grainEnvelope;
+        std::vector<GrainRenderer::Gains> tickGains;
+    };
+    std::vector<RenderScratch> renderScratch { 1 };
+    
+    // Everything renderItem needs that is shared by all particles in a block
+    struct BlockRenderState
+    {
+        GrainRenderer::Source source {};
+        GrainRenderer::Source fadingSource {};   // Empty unless crossfading from another sample
+        float sourceRateRatio = 1.0f;            // Render buffer rate over host rate; 1 once converted
+        float fadingSourceRateRatio = 1.0f;
+        const float* crossfadeIn = nullptr;      // Per-sample gains; nullptr unless crossfading
+        const float* crossfadeOut = nullptr;
+        GrainRenderer::Interpolation interpolation = GrainRenderer::Interpolation::Hermite;
+        float grainSizeMs = 0.0f;
+        float grainFreq = 0.0f;
+        float masterGain = 0.0f;
+        float gainCompensation = 1.0f;
+        double sampleRate = 0.0;
+    };
+    BlockRenderState blockRenderState;
+    
+    // Leave one physical core for the host
+    int maxRenderWorkers = juce::jlimit (0, 7, juce::SystemStats::getNumPhysicalCpus() - 1);
+    GrainRenderPool renderPool;
+    double preparedSampleRate = 0.0;
+    
+    // Message thread: starts or stops the workers to match multiCore (from parameterChanged)
+    void handleAsyncUpdate() override;
+    void prepareRenderWorkers();
+    
+    // Renders particle item for the current block (GrainRenderPool::Job)
+    void renderItem (int item, int threadIndex, float* leftChannel, float* rightChannel, int numSamples) override;
+    
+    void processChunk (juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const juce::MidiBuffer& midiMessages);
+    void reserveParticleStorage();
+    void publishPointScene();
+    void updateSampleCrossfade (int numSamples);
+    void updatePrefetchWindows();
+    void removeParticle (int index);
+    void handleMidiMessage (const juce::MidiMessage& message);
+    void handleUiMidi (juce::int64 blockEnd);
     void handleNoteOn (int noteNumber, float velocity, float pitchShift);
     void handleNoteOff (int noteNumber);
-    void updateParticleSimulation (double currentTime, int bufferSize);
+    void updateParticleSimulation (int numSamples);
+    void publishParticleSnapshot();
+    void stepParticleSimulation (float deltaTime);
+    bool updateGravityField();
+    int getControlInterval() const;
 };
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Read-copy-update hand-over of an immutable object from one writer thread to one
+// reader thread. The writer publishes a whole new object with an atomic pointer swap;
+// the reader holds whichever object was current when it started reading, without
+// waiting or allocating. Replaced objects are freed on the writer thread, once the
+// reader can no longer be looking at them.
+template <typename T>
+class RcuObject
+{
+public:
+    RcuObject() : current (new T()) {}
+
+    ~RcuObject()
+    {
+        delete current.load();
+    }
+
+    //==============================================================================
+    // Writer only. Not real-time safe: allocates, and frees retired objects.
+    void publish (std::unique_ptr<T> next)
+    {
+        auto* previous = current.exchange (next.release());
+
+        // Sampled after the swap: if the reader is outside a read now, its next read
+        // sees the new object; if it's inside, it's done once the count moves on
+        retired.push_back ({ std::unique_ptr<T> (previous), readerState.load() });
+        reclaim();
+    }
+
+    // Writer only. Frees every retired object the reader has finished with.
+    void reclaim()
+    {
+        const auto state = readerState.load();
+
+        retired.erase (std::remove_if (retired.begin(), retired.end(), [state] (const Retired& r)
+                                       {
+                                           return (r.readerState & 1) == 0 || r.readerState != state;
+                                       }),
+                       retired.end());
+    }
+
+    // Writer only. The most recently published object.
+    const T& getLatest() const { return *current.load(); }
+
+    int getNumRetired() const { return static_cast<int>(retired.size()); }
+
+    //==============================================================================
+    // Reader only, and not nested. The object stays valid for the lifetime of the scope.
+    class ReadScope
+    {
+    public:
+        explicit ReadScope (RcuObject& rcu)
+            : owner (rcu)
+        {
+            owner.readerState.fetch_add (1);   // Odd: reading
+            object = owner.current.load();
+        }
+
+        ~ReadScope()
+        {
+            owner.readerState.fetch_add (1);   // Even: done
+        }
+
+        const T& operator*() const { return *object; }
+        const T* operator->() const { return object; }
+        const T* get() const { return object; }
+
+    private:
+        RcuObject& owner;
+        const T* object = nullptr;
+
+        ReadScope (const ReadScope&) = delete;
+        ReadScope& operator= (const ReadScope&) = delete;
+    };
+
+private:
+    struct Retired
+    {
+        std::unique_ptr<T> object;
+        uint64_t readerState;
+    };
+
+    std::atomic<T*> current;
+    std::atomic<uint64_t> readerState { 0 };   // Bumped on entering and leaving each read
+    std::vector<Retired> retired;
+
+    RcuObject (const RcuObject&) = delete;
+    RcuObject& operator= (const RcuObject&) = delete;
+};
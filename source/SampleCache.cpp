@@ -0,0 +1,96 @@
+#include "SampleCache.h"
+#include <algorithm>
+#include <tuple>
+
+bool SampleCache::Key::operator< (const Key& other) const
+{
+    return std::tie (path, modificationTime, size, renderSampleRate, streamingThreshold)
+         < std::tie (other.path, other.modificationTime, other.size, other.renderSampleRate, other.streamingThreshold);
+}
+
+SampleCache::Key SampleCache::makeKey (const juce::File& file, double renderSampleRate, juce::int64 streamingThreshold)
+{
+    const auto target = file.getLinkedTarget();
+
+    Key key;
+    key.path = target.getFullPathName();
+    key.modificationTime = target.getLastModificationTime().toMilliseconds();
+    key.size = target.getSize();
+    key.renderSampleRate = renderSampleRate;
+    key.streamingThreshold = streamingThreshold;
+    return key;
+}
+
+std::shared_ptr<const LoadedSample> SampleCache::getOrLoad (const Key& key, const Loader& load,
+                                                            const std::function<bool()>& shouldStop)
+{
+    while (! shouldStop())
+    {
+        std::shared_ptr<PendingLoad> pending;
+        bool isLoading = false;
+
+        {
+            const juce::ScopedLock scopedLock (lock);
+            removeExpired();
+
+            auto& entry = entries[key];
+
+            if (auto sample = entry.sample.lock())
+                return sample;
+
+            if (entry.pending == nullptr)
+            {
+                entry.pending = std::make_shared<PendingLoad>();
+                isLoading = true;
+            }
+
+            pending = entry.pending;
+        }
+
+        if (isLoading)
+        {
+            auto sample = load();
+
+            {
+                const juce::ScopedLock scopedLock (lock);
+                auto& entry = entries[key];
+                entry.sample = sample;
+                entry.pending.reset();
+            }
+
+            pending->result = sample;
+            pending->finished.signal();
+            return sample;
+        }
+
+        while (! pending->finished.wait (pollIntervalMs))
+            if (shouldStop())
+                return nullptr;
+
+        if (pending->result != nullptr)
+            return pending->result;
+
+        // The load failed or was abandoned; try it here, unless another thread already has
+    }
+
+    return nullptr;
+}
+
+int SampleCache::getNumCachedSamples() const
+{
+    const juce::ScopedLock scopedLock (lock);
+
+    return static_cast<int> (std::count_if (entries.begin(), entries.end(),
+                                            [] (const auto& entry) { return ! entry.second.sample.expired(); }));
+}
+
+void SampleCache::removeExpired()
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.sample.expired() && it->second.pending == nullptr)
+            it = entries.erase (it);
+        else
+            ++it;
+    }
+}
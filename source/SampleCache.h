@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <map>
+#include <memory>
+
+struct LoadedSample;
+
+//==============================================================================
+// Decoded samples shared by every plugin instance in the process, so a session with
+// many instances on the same few files decodes and holds each file once. Held through
+// juce::SharedResourcePointer; entries only keep weak references, so a sample is freed
+// as soon as the last instance lets go of it.
+//
+// Samples are immutable once loaded, which is what makes sharing them safe.
+class SampleCache
+{
+public:
+    // Everything a loaded sample depends on. A file edited on disk gets a new key.
+    struct Key
+    {
+        juce::String path;   // Symlinks resolved
+        juce::int64 modificationTime = 0;
+        juce::int64 size = 0;
+        double renderSampleRate = 0.0;
+        juce::int64 streamingThreshold = 0;
+
+        bool operator< (const Key& other) const;
+    };
+
+    static Key makeKey (const juce::File& file, double renderSampleRate, juce::int64 streamingThreshold);
+
+    using Loader = std::function<std::shared_ptr<const LoadedSample>()>;
+
+    // Returns the cached sample for key, or calls load to make it. If another thread is
+    // already loading the same key, waits for that instead of decoding it twice, giving
+    // up (returning nullptr) if shouldStop returns true. A failed load isn't cached.
+    std::shared_ptr<const LoadedSample> getOrLoad (const Key& key, const Loader& load,
+                                                   const std::function<bool()>& shouldStop);
+
+    int getNumCachedSamples() const;
+
+private:
+    struct PendingLoad
+    {
+        juce::WaitableEvent finished { true };
+        std::shared_ptr<const LoadedSample> result;
+    };
+
+    struct Entry
+    {
+        std::weak_ptr<const LoadedSample> sample;
+        std::shared_ptr<PendingLoad> pending;   // Set while a thread is loading it
+    };
+
+    void removeExpired();
+
+    juce::CriticalSection lock;
+    std::map<Key, Entry> entries;
+
+    // How often a waiting thread checks shouldStop
+    static constexpr int pollIntervalMs = 50;
+};
@@ -0,0 +1,494 @@
+#include "SampleLoader.h"
+#include "GrainRenderer.h"
+#include "Logger.h"
+#include "SampleRateConverter.h"
+#include <optional>
+
+GrainRenderer::Source LoadedSample::getSource() const
+{
+    if (mappedRenderBuffer == nullptr)
+        return GrainRenderer::getSource (renderBuffer);
+
+    GrainRenderer::Source source;
+    source.samples = static_cast<const float*> (mappedRenderBuffer->getData()) + GrainRenderer::guardSamples;
+    source.numSamples = numMappedSamples;
+    return source;
+}
+
+//==============================================================================
+// Touches the pages of the audio thread's prefetch windows, so a grain starting there
+// finds them in memory instead of faulting them in from disk mid-callback
+class SampleLoader::Prefetcher : public juce::Thread
+{
+public:
+    explicit Prefetcher (SampleLoader& ownerLoader)
+        : juce::Thread ("Orbit sample prefetcher"),
+          loader (ownerLoader)
+    {
+    }
+
+    ~Prefetcher() override
+    {
+        stopThread (1000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            loader.prefetch();
+            wait (intervalMs);
+        }
+    }
+
+private:
+    SampleLoader& loader;
+
+    // Well inside the prediction horizon the audio thread uses
+    static constexpr int intervalMs = 10;
+};
+
+//==============================================================================
+SampleLoader::SampleLoader()
+    : juce::Thread ("Orbit sample loader")
+{
+    formatManager.registerBasicFormats();
+    startThread (juce::Thread::Priority::background);
+
+    prefetcher = std::make_unique<Prefetcher> (*this);
+    prefetcher->startThread (juce::Thread::Priority::normal);
+}
+
+SampleLoader::~SampleLoader()
+{
+    prefetcher.reset();
+    stopThread (4000);
+}
+
+void SampleLoader::load (const juce::File& file)
+{
+    {
+        const juce::ScopedLock scopedLock (lock);
+        requestedFile = file;
+        hasRequest = true;
+        busy = true;
+    }
+
+    notify();
+}
+
+bool SampleLoader::waitUntilIdle (int timeoutMs)
+{
+    const auto timeout = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+
+    while (busy.load())
+    {
+        if (juce::Time::getMillisecondCounter() >= timeout)
+            return false;
+
+        juce::Thread::sleep (1);
+    }
+
+    return true;
+}
+
+void SampleLoader::setTargetSampleRate (double newRate)
+{
+    if (targetSampleRate.exchange (newRate) == newRate)
+        return;
+
+    juce::File file;
+
+    {
+        const juce::ScopedLock scopedLock (lock);
+
+        // A load that hasn't started yet picks the new rate up anyway
+        if (hasRequest)
+            return;
+
+        // A load in progress may have read the old rate, so that file is converted again
+        if (busy)
+            file = requestedFile;
+        else if (latest != nullptr && latest->renderSampleRate != newRate)
+            file = latest->file;
+    }
+
+    if (file != juce::File())
+        load (file);
+}
+
+std::shared_ptr<const LoadedSample> SampleLoader::getLatest() const
+{
+    const juce::ScopedLock scopedLock (lock);
+    return latest;
+}
+
+const LoadedSample* SampleLoader::takeLoaded()
+{
+    if (ready.load (std::memory_order_relaxed) == nullptr)
+        return nullptr;
+
+    return ready.exchange (nullptr, std::memory_order_acquire);
+}
+
+bool SampleLoader::retire (const LoadedSample* sample)
+{
+    const LoadedSample* expected = nullptr;
+    return retired.compare_exchange_strong (expected, sample, std::memory_order_release);
+}
+
+void SampleLoader::setPrefetchWindows (const LoadedSample* sample, const juce::Range<int>* windows, int numWindows)
+{
+    numWindows = juce::jmin (numWindows, maxPrefetchWindows);
+
+    for (int i = 0; i < numWindows; ++i)
+    {
+        prefetchRanges[static_cast<size_t>(2 * i)].store (windows[i].getStart(), std::memory_order_relaxed);
+        prefetchRanges[static_cast<size_t>(2 * i + 1)].store (windows[i].getEnd(), std::memory_order_relaxed);
+    }
+
+    numPrefetchWindows.store (numWindows, std::memory_order_relaxed);
+    prefetchSample.store (sample, std::memory_order_release);
+}
+
+void SampleLoader::prefetch()
+{
+    const auto* sample = prefetchSample.load (std::memory_order_acquire);
+
+    if (sample == nullptr)
+        return;
+
+    // Held so the sample can't be freed while its pages are read
+    const juce::ScopedLock scopedLock (handedOutLock);
+
+    const bool isAlive = std::any_of (handedOut.begin(), handedOut.end(),
+                                      [sample] (const auto& s) { return s.get() == sample; });
+
+    if (! isAlive || ! sample->isStreamed())
+        return;
+
+    const auto source = sample->getSource();
+    constexpr int samplesPerPage = 4096 / static_cast<int> (sizeof (float));
+    float sum = 0.0f;
+
+    const int numWindows = numPrefetchWindows.load (std::memory_order_relaxed);
+
+    for (int i = 0; i < numWindows; ++i)
+    {
+        const int start = juce::jlimit (0, source.numSamples, prefetchRanges[static_cast<size_t>(2 * i)].load (std::memory_order_relaxed));
+        const int end = juce::jlimit (start, source.numSamples, prefetchRanges[static_cast<size_t>(2 * i + 1)].load (std::memory_order_relaxed));
+
+        for (int index = start; index < end; index += samplesPerPage)
+            sum += source.samples[index];
+
+        if (end > start)
+            sum += source.samples[end - 1];
+    }
+
+    // Keeps the reads from being optimised away
+    static std::atomic<float> sink { 0.0f };
+    sink.store (sum, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void SampleLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        collectRetired();
+
+        juce::File file;
+
+        {
+            const juce::ScopedLock scopedLock (lock);
+
+            if (hasRequest)
+            {
+                file = requestedFile;
+                hasRequest = false;
+            }
+            else
+            {
+                busy = false;
+            }
+        }
+
+        if (file == juce::File())
+        {
+            wait (collectIntervalMs);
+            continue;
+        }
+
+        auto sample = decode (file);
+
+        if (sample == nullptr)
+            continue;
+
+        {
+            const juce::ScopedLock scopedLock (handedOutLock);
+            handedOut.push_back (sample);
+
+            // If the audio thread never took the previous sample, it never will
+            if (auto* skipped = ready.exchange (sample.get(), std::memory_order_acq_rel))
+                handedOut.erase (std::find_if (handedOut.begin(), handedOut.end(),
+                                               [skipped] (const auto& s) { return s.get() == skipped; }));
+        }
+
+        const juce::ScopedLock scopedLock (lock);
+        latest = std::move (sample);
+    }
+
+    collectRetired();
+}
+
+void SampleLoader::collectRetired()
+{
+    if (auto* sample = retired.exchange (nullptr, std::memory_order_acquire))
+    {
+        const juce::ScopedLock scopedLock (handedOutLock);
+        handedOut.erase (std::find_if (handedOut.begin(), handedOut.end(),
+                                       [sample] (const auto& s) { return s.get() == sample; }));
+    }
+}
+
+std::shared_ptr<const LoadedSample> SampleLoader::decode (const juce::File& file)
+{
+    // Read once, so the key matches what decodeFile produces
+    const double targetRate = targetSampleRate.load();
+    const auto threshold = streamingThreshold.load();
+
+    return sampleCache->getOrLoad (SampleCache::makeKey (file, targetRate, threshold),
+                                   [&] { return decodeFile (file, targetRate, threshold); },
+                                   [this] { return threadShouldExit(); });
+}
+
+std::shared_ptr<const LoadedSample> SampleLoader::decodeFile (const juce::File& file, double targetRate, juce::int64 threshold)
+{
+    LOG_INFO("Loading audio file: " + file.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+    if (reader == nullptr)
+    {
+        LOG_WARNING("Failed to create audio reader for: " + file.getFullPathName());
+        return nullptr;
+    }
+
+    auto sample = std::make_shared<LoadedSample>();
+    sample->file = file;
+    sample->sampleRate = reader->sampleRate;
+    sample->renderSampleRate = reader->sampleRate;
+
+    // Left at the file's rate until the host has told us its own (targetRate is 0)
+    if (reader->lengthInSamples > threshold)
+    {
+        if (! decodeToCacheFile (*reader, *sample, targetRate))
+            return nullptr;
+
+        LOG_INFO("Audio file streamed - " + juce::String(reader->numChannels) + " ch, " +
+                 juce::String(reader->sampleRate) + " Hz, " +
+                 juce::String(reader->lengthInSamples / reader->sampleRate, 2) + "s");
+
+        return sample;
+    }
+
+    sample->audio.setSize (static_cast<int>(reader->numChannels),
+                           static_cast<int>(reader->lengthInSamples));
+
+    reader->read (&sample->audio,
+                  0,
+                  static_cast<int>(reader->lengthInSamples),
+                  0,
+                  true,
+                  true);
+
+    GrainRenderer::buildRenderBuffer (sample->audio, sample->renderBuffer);
+
+    if (targetRate > 0.0 && targetRate != sample->sampleRate && ! resampleRenderBuffer (*sample, targetRate))
+        return nullptr;
+
+    LOG_INFO("Audio file loaded - " + juce::String(reader->numChannels) + " ch, " +
+             juce::String(reader->sampleRate) + " Hz, " +
+             juce::String(reader->lengthInSamples / reader->sampleRate, 2) + "s");
+
+    return sample;
+}
+
+bool SampleLoader::resampleRenderBuffer (LoadedSample& sample, double targetRate)
+{
+    constexpr int chunkSize = 1 << 16;
+
+    SampleRateConverter converter (sample.sampleRate, targetRate);
+    const auto source = GrainRenderer::getSource (sample.renderBuffer);
+    const auto outputLength = converter.getOutputLength (source.numSamples);
+
+    if (outputLength + 2 * GrainRenderer::guardSamples > std::numeric_limits<int>::max())
+    {
+        LOG_WARNING("Audio file too long to resample: " + sample.file.getFullPathName());
+        return false;
+    }
+
+    std::vector<float> resampled;
+    resampled.reserve (static_cast<size_t> (outputLength));
+
+    for (int position = 0; position < source.numSamples; position += chunkSize)
+    {
+        if (threadShouldExit())
+            return false;
+
+        converter.process (source.samples + position, juce::jmin (chunkSize, source.numSamples - position), resampled);
+    }
+
+    converter.finish (resampled);
+
+    float* channels[] = { resampled.data() };
+    const juce::AudioBuffer<float> mono (channels, 1, static_cast<int> (resampled.size()));
+    GrainRenderer::buildRenderBuffer (mono, sample.renderBuffer);
+    sample.renderSampleRate = targetRate;
+
+    return true;
+}
+
+bool SampleLoader::decodeToCacheFile (juce::AudioFormatReader& reader, LoadedSample& sample, double targetRate)
+{
+    constexpr int guardSamples = GrainRenderer::guardSamples;
+    constexpr int chunkSize = 1 << 16;
+    constexpr int maxOverviewSamples = 1 << 18;
+
+    const auto length = reader.lengthInSamples;
+    const int numChannels = static_cast<int> (reader.numChannels);
+
+    std::optional<SampleRateConverter> converter;
+    if (targetRate > 0.0 && targetRate != sample.sampleRate)
+        converter.emplace (sample.sampleRate, targetRate);
+
+    const auto renderLength = converter.has_value() ? converter->getOutputLength (length) : length;
+
+    if (renderLength + 2 * guardSamples > std::numeric_limits<int>::max() || numChannels <= 0)
+    {
+        LOG_WARNING("Audio file too long to stream: " + sample.file.getFullPathName());
+        return false;
+    }
+
+    // The display gets the loudest sample of every stride, so peaks survive
+    sample.overviewStride = static_cast<int> ((length + maxOverviewSamples - 1) / maxOverviewSamples);
+    sample.audio.setSize (numChannels, static_cast<int> ((length + sample.overviewStride - 1) / sample.overviewStride));
+    sample.audio.clear();
+
+    sample.cacheFile = std::make_unique<juce::TemporaryFile> (".orbitcache");
+    juce::int64 numWritten = 0;
+
+    {
+        juce::FileOutputStream out (sample.cacheFile->getFile());
+
+        if (out.failedToOpen())
+        {
+            LOG_WARNING("Couldn't create stream cache: " + sample.cacheFile->getFile().getFullPathName());
+            return false;
+        }
+
+        juce::AudioBuffer<float> chunk (numChannels, chunkSize);
+        std::vector<float> mono (static_cast<size_t> (chunkSize));
+        std::vector<float> resampled;
+        std::array<float, guardSamples> firstSamples {}, lastSamplesRing {};
+        const float channelMult = 1.0f / static_cast<float> (numChannels);
+
+        // Keeps the first few render samples, and the last few so far, for the guards
+        auto writeRendered = [&] (const float* data, size_t numSamples)
+        {
+            for (size_t i = 0; i < numSamples; ++i, ++numWritten)
+            {
+                if (numWritten < guardSamples)
+                    firstSamples[static_cast<size_t> (numWritten)] = data[i];
+
+                lastSamplesRing[static_cast<size_t> (numWritten % guardSamples)] = data[i];
+            }
+
+            out.write (data, numSamples * sizeof (float));
+        };
+
+        // Leading guard, filled in once the end of the file is known
+        out.write (firstSamples.data(), sizeof (firstSamples));
+
+        for (juce::int64 position = 0; position < length; position += chunkSize)
+        {
+            if (threadShouldExit())
+                return false;
+
+            const int numSamples = static_cast<int> (juce::jmin<juce::int64> (chunkSize, length - position));
+            reader.read (&chunk, 0, numSamples, position, true, true);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* input = chunk.getReadPointer (channel);
+                auto* overview = sample.audio.getWritePointer (channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto& peak = overview[(position + i) / sample.overviewStride];
+                    if (std::abs (input[i]) > std::abs (peak))
+                        peak = input[i];
+                }
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float sum = 0.0f;
+                for (int channel = 0; channel < numChannels; ++channel)
+                    sum += chunk.getReadPointer (channel)[i];
+                mono[static_cast<size_t> (i)] = sum * channelMult;
+            }
+
+            if (converter.has_value())
+            {
+                resampled.clear();
+                converter->process (mono.data(), numSamples, resampled);
+                writeRendered (resampled.data(), resampled.size());
+            }
+            else
+            {
+                writeRendered (mono.data(), static_cast<size_t> (numSamples));
+            }
+        }
+
+        if (converter.has_value())
+        {
+            resampled.clear();
+            converter->finish (resampled);
+            writeRendered (resampled.data(), resampled.size());
+        }
+
+        // Wrap-around copies of the opposite end, as in GrainRenderer::buildRenderBuffer.
+        // The last samples written sit in lastSamplesRing as a ring ending at numWritten - 1.
+        std::array<float, guardSamples> leadingGuard {};
+        for (int i = 0; i < guardSamples; ++i)
+            leadingGuard[static_cast<size_t> (i)] = lastSamplesRing[static_cast<size_t> ((numWritten + i) % guardSamples)];
+
+        out.write (firstSamples.data(), sizeof (firstSamples));
+        out.setPosition (0);
+        out.write (leadingGuard.data(), sizeof (leadingGuard));
+        out.flush();
+
+        if (out.getStatus().failed())
+        {
+            LOG_WARNING("Couldn't write stream cache: " + out.getStatus().getErrorMessage());
+            return false;
+        }
+    }
+
+    sample.mappedRenderBuffer = std::make_unique<juce::MemoryMappedFile> (sample.cacheFile->getFile(),
+                                                                         juce::MemoryMappedFile::readOnly);
+
+    if (sample.mappedRenderBuffer->getData() == nullptr)
+    {
+        LOG_WARNING("Couldn't map stream cache: " + sample.cacheFile->getFile().getFullPathName());
+        return false;
+    }
+
+    sample.numMappedSamples = static_cast<int> (numWritten);
+
+    if (converter.has_value())
+        sample.renderSampleRate = targetRate;
+
+    return true;
+}
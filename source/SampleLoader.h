@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "GrainRenderer.h"
+#include "SampleCache.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// A decoded audio file and everything derived from it. Never changed once loaded.
+//
+// Long files are streamed: their render buffer is written to a cache file on disk and
+// memory-mapped, so the OS pages it in as grains read it (see SampleLoader's prefetch
+// windows) and RAM use doesn't grow with the file's length.
+struct LoadedSample
+{
+    juce::File file;
+    juce::AudioBuffer<float> audio;    // Original channels for display; an overview when streamed
+    int overviewStride = 1;            // Source samples per sample of audio
+    double sampleRate = 0.0;           // The file's own rate, which audio is at
+    double renderSampleRate = 0.0;     // The session rate the render buffer was converted to, if known
+
+    std::vector<float> renderBuffer;   // Guard-padded mono mixdown the grains read from, when in memory
+
+    std::unique_ptr<juce::TemporaryFile> cacheFile;
+    std::unique_ptr<juce::MemoryMappedFile> mappedRenderBuffer;   // Same layout as renderBuffer, when streamed
+    int numMappedSamples = 0;
+
+    bool isStreamed() const { return mappedRenderBuffer != nullptr; }
+    GrainRenderer::Source getSource() const;
+};
+
+//==============================================================================
+// Decodes audio files on a background thread and hands the results to the audio
+// thread through an atomic slot. The audio thread gives samples back through a second
+// slot once it's done with them, and they're freed here rather than in the callback.
+// The message thread shares the latest sample for display.
+//
+// Samples come from the process-wide SampleCache, so instances loading the same file
+// share one copy.
+class SampleLoader : private juce::Thread
+{
+public:
+    SampleLoader();
+    ~SampleLoader() override;
+
+    // Message thread. Replaces any load that hasn't started yet.
+    void load (const juce::File& file);
+
+    // Message thread. Blocks until every requested load has been decoded (or failed).
+    bool waitUntilIdle (int timeoutMs);
+
+    // Message thread. The most recently decoded sample, or nullptr.
+    std::shared_ptr<const LoadedSample> getLatest() const;
+
+    // Files longer than this many samples are streamed from a cache file (default about
+    // six minutes at 44.1 kHz). Applies to loads that haven't started yet.
+    void setStreamingThreshold (juce::int64 numSamples) { streamingThreshold = numSamples; }
+
+    // Render buffers are resampled to this rate as they're decoded, so grains play at the
+    // right pitch without per-sample ratio math. A change reloads the current file.
+    void setTargetSampleRate (double newRate);
+
+    // Audio thread. Takes the newest decoded sample not yet taken, or returns nullptr.
+    // The sample stays valid until it's passed back to retire.
+    const LoadedSample* takeLoaded();
+
+    // Audio thread. Gives back a sample taken earlier. Returns false if the previous one
+    // hasn't been collected yet, in which case try again on a later block.
+    bool retire (const LoadedSample* sample);
+
+    // Audio thread. Render buffer ranges of a streamed sample that grains are about to
+    // read, for a background thread to page in. Only the first maxPrefetchWindows are used.
+    static constexpr int maxPrefetchWindows = 512;
+    void setPrefetchWindows (const LoadedSample* sample, const juce::Range<int>* windows, int numWindows);
+
+private:
+    class Prefetcher;
+
+    void run() override;
+    std::shared_ptr<const LoadedSample> decode (const juce::File& file);
+    std::shared_ptr<const LoadedSample> decodeFile (const juce::File& file, double targetRate, juce::int64 threshold);
+    bool decodeToCacheFile (juce::AudioFormatReader& reader, LoadedSample& sample, double targetRate);
+    bool resampleRenderBuffer (LoadedSample& sample, double targetRate);
+    void collectRetired();
+    void prefetch();
+
+    juce::AudioFormatManager formatManager;
+    juce::SharedResourcePointer<SampleCache> sampleCache;
+
+    juce::CriticalSection lock;   // Never taken by the audio thread
+    juce::File requestedFile;
+    bool hasRequest = false;
+    std::shared_ptr<const LoadedSample> latest;
+    std::atomic<bool> busy { false };
+    std::atomic<juce::int64> streamingThreshold { juce::int64 (1) << 24 };
+    std::atomic<double> targetSampleRate { 0.0 };   // 0 until the host sets one; no conversion
+
+    // Every sample the audio thread may hold. Changed only by the loader thread; the
+    // prefetcher holds the lock while it reads from one of them.
+    juce::CriticalSection handedOutLock;
+    std::vector<std::shared_ptr<const LoadedSample>> handedOut;
+
+    std::atomic<const LoadedSample*> ready { nullptr };
+    std::atomic<const LoadedSample*> retired { nullptr };
+
+    // Written by the audio thread each block. Only hints, so torn ranges do no harm.
+    std::atomic<const LoadedSample*> prefetchSample { nullptr };
+    std::array<std::atomic<int>, 2 * maxPrefetchWindows> prefetchRanges {};
+    std::atomic<int> numPrefetchWindows { 0 };
+
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    // How often the loader thread collects retired samples while idle
+    static constexpr int collectIntervalMs = 50;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoader)
+};
@@ -0,0 +1,117 @@
+#include "SampleRateConverter.h"
+#include <cmath>
+
+namespace
+{
+    // Keeps a little of the band below Nyquist for the filter's transition
+    constexpr double rolloff = 0.95;
+    constexpr double kaiserBeta = 9.0;
+
+    // Zeroth-order modified Bessel function of the first kind
+    double besselI0 (double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+}
+
+//==============================================================================
+SampleRateConverter::SampleRateConverter (double sourceRate, double targetRate)
+    : ratio (sourceRate / targetRate),
+      cutoff (sourceRate == targetRate ? 1.0 : juce::jmin (1.0, targetRate / sourceRate) * rolloff),
+      radius (halfTaps / cutoff),
+      kernel (getKernel())
+{
+    jassert (sourceRate > 0.0 && targetRate > 0.0);
+}
+
+const std::vector<float>& SampleRateConverter::getKernel()
+{
+    static const std::vector<float> table = []
+    {
+        std::vector<float> values (static_cast<size_t>(kernelResolution + 2), 0.0f);
+        const double windowNorm = besselI0 (kaiserBeta);
+
+        for (int i = 0; i <= kernelResolution; ++i)
+        {
+            const double u = static_cast<double>(i) / kernelResolution;
+            const double x = juce::MathConstants<double>::pi * halfTaps * u;
+            const double sinc = i == 0 ? 1.0 : std::sin (x) / x;
+            const double window = besselI0 (kaiserBeta * std::sqrt (1.0 - u * u)) / windowNorm;
+            values[static_cast<size_t>(i)] = static_cast<float>(sinc * window);
+        }
+
+        return values;
+    }();
+
+    return table;
+}
+
+juce::int64 SampleRateConverter::getOutputLength (juce::int64 length) const
+{
+    return static_cast<juce::int64>(std::ceil (static_cast<double>(length) / ratio));
+}
+
+void SampleRateConverter::process (const float* input, int numSamples, std::vector<float>& output)
+{
+    history.insert (history.end(), input, input + numSamples);
+    inputLength += numSamples;
+
+    // Output n needs input up to floor(n * ratio + radius)
+    const auto endOutput = static_cast<juce::int64>(std::ceil ((static_cast<double>(inputLength) - radius) / ratio));
+    produce (endOutput, output);
+
+    // Drop input no later output will read, in large steps to keep erasing cheap
+    const auto firstNeeded = static_cast<juce::int64>(std::floor (static_cast<double>(nextOutput) * ratio - radius));
+    const auto numUnneeded = firstNeeded - historyStart;
+
+    if (numUnneeded > static_cast<juce::int64>(history.size()) / 2)
+    {
+        history.erase (history.begin(), history.begin() + static_cast<std::ptrdiff_t>(numUnneeded));
+        historyStart = firstNeeded;
+    }
+}
+
+void SampleRateConverter::finish (std::vector<float>& output)
+{
+    produce (getOutputLength (inputLength), output);
+}
+
+void SampleRateConverter::produce (juce::int64 endOutput, std::vector<float>& output)
+{
+    for (; nextOutput < endOutput; ++nextOutput)
+        output.push_back (computeSample (nextOutput));
+}
+
+float SampleRateConverter::computeSample (juce::int64 outputIndex) const
+{
+    const double centre = static_cast<double>(outputIndex) * ratio;
+    const auto first = juce::jmax (historyStart, static_cast<juce::int64>(std::floor (centre - radius)) + 1);
+    const auto last = juce::jmin (inputLength - 1, static_cast<juce::int64>(std::floor (centre + radius)));
+    const double scale = kernelResolution / radius;
+
+    double sum = 0.0;
+
+    for (auto index = first; index <= last; ++index)
+    {
+        const double position = std::abs (centre - static_cast<double>(index)) * scale;
+        const auto tap = static_cast<int>(position);
+        const auto fraction = static_cast<float>(position - tap);
+        const float weight = kernel[static_cast<size_t>(tap)] + fraction * (kernel[static_cast<size_t>(tap + 1)] - kernel[static_cast<size_t>(tap)]);
+
+        sum += static_cast<double>(weight * history[static_cast<size_t>(index - historyStart)]);
+    }
+
+    return static_cast<float>(sum * cutoff);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+//==============================================================================
+// Offline band-limited resampling with a Kaiser-windowed sinc, for converting a loaded
+// file to the session rate once so the grain renderer never has to. Input is fed in
+// blocks of any size and every output sample is produced as soon as all of the input
+// it depends on has arrived, so arbitrarily long files convert in constant memory.
+//
+// When downsampling the kernel widens to cut off below the new Nyquist frequency. At
+// equal rates every tap but the centre lands on a zero crossing, so samples pass through.
+class SampleRateConverter
+{
+public:
+    SampleRateConverter (double sourceRate, double targetRate);
+
+    // Zero crossings of the sinc either side of each output sample
+    static constexpr int halfTaps = 32;
+
+    // Input samples per output sample
+    double getRatio() const { return ratio; }
+    juce::int64 getOutputLength (juce::int64 inputLength) const;
+
+    // Appends every output sample the input so far fully determines
+    void process (const float* input, int numSamples, std::vector<float>& output);
+
+    // After the last input: appends the remaining output samples, reading silence past the end
+    void finish (std::vector<float>& output);
+
+private:
+    float computeSample (juce::int64 outputIndex) const;
+    void produce (juce::int64 endOutput, std::vector<float>& output);
+
+    double ratio = 1.0;
+    double cutoff = 1.0;   // Relative to the lower of the two Nyquist frequencies
+    double radius = 0.0;   // Kernel half-width in input samples
+
+    // The windowed sinc over [0, 1] of the half-width, shared by every instance
+    static constexpr int kernelResolution = 4096;
+    static const std::vector<float>& getKernel();
+    const std::vector<float>& kernel;
+
+    std::vector<float> history;        // Input from historyStart on
+    juce::int64 historyStart = 0;
+    juce::int64 inputLength = 0;       // Input received so far
+    juce::int64 nextOutput = 0;
+};
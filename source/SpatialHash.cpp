@@ -0,0 +1,55 @@
+#include "SpatialHash.h"
+
+//==============================================================================
+void SpatialHash::reserve (int maxBodies)
+{
+    cellStart.resize (static_cast<size_t>(maxCellsPerSide * maxCellsPerSide + 1), 0);
+    sortedBodies.resize (static_cast<size_t>(maxBodies));
+    bodyCell.resize (static_cast<size_t>(maxBodies));
+}
+
+void SpatialHash::build (const float* x, const float* y, const float* weight, int count,
+                         juce::Rectangle<float> bounds, float cellSize)
+{
+    jassert (count <= static_cast<int>(bodyCell.size()));
+    jassert (cellSize > 0.0f);
+
+    numColumns = juce::jlimit (1, maxCellsPerSide, static_cast<int>(bounds.getWidth() / cellSize));
+    numRows = juce::jlimit (1, maxCellsPerSide, static_cast<int>(bounds.getHeight() / cellSize));
+    const int numCells = numColumns * numRows;
+
+    // Cells may come out bigger than cellSize, never smaller
+    const float columnsPerUnit = bounds.getWidth() > 0.0f ? static_cast<float>(numColumns) / bounds.getWidth() : 0.0f;
+    const float rowsPerUnit = bounds.getHeight() > 0.0f ? static_cast<float>(numRows) / bounds.getHeight() : 0.0f;
+
+    std::fill (cellStart.begin(), cellStart.begin() + numCells + 1, 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto& cell = bodyCell[static_cast<size_t>(i)];
+
+        if (weight[i] <= 0.0f)
+        {
+            cell = -1;
+            continue;
+        }
+
+        const int column = juce::jlimit (0, numColumns - 1, static_cast<int>((x[i] - bounds.getX()) * columnsPerUnit));
+        const int row = juce::jlimit (0, numRows - 1, static_cast<int>((y[i] - bounds.getY()) * rowsPerUnit));
+        cell = row * numColumns + column;
+        ++cellStart[static_cast<size_t>(cell + 1)];
+    }
+
+    for (int c = 0; c < numCells; ++c)
+        cellStart[static_cast<size_t>(c + 1)] += cellStart[static_cast<size_t>(c)];
+
+    // Scatter, using cellStart[c] as the write cursor, then shift the starts back
+    for (int i = 0; i < count; ++i)
+        if (const int cell = bodyCell[static_cast<size_t>(i)]; cell >= 0)
+            sortedBodies[static_cast<size_t>(cellStart[static_cast<size_t>(cell)]++)] = i;
+
+    for (int c = numCells; c > 0; --c)
+        cellStart[static_cast<size_t>(c)] = cellStart[static_cast<size_t>(c - 1)];
+
+    cellStart[0] = 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <vector>
+
+//==============================================================================
+// Uniform grid over the canvas for finding bodies near each other in linear time.
+// Bodies are counting-sorted into cells each build, so the buckets are two flat
+// arrays sized up front and building never allocates.
+class SpatialHash
+{
+public:
+    static constexpr int maxCellsPerSide = 64;
+
+    SpatialHash() = default;
+
+    // Not real-time safe. Nothing is allocated until this is called.
+    void reserve (int maxBodies);
+
+    // Sorts the bodies into cells of at least cellSize over bounds (bodies outside are
+    // clamped to the edge cells). Bodies with a weight of 0 or less are left out.
+    void build (const float* x, const float* y, const float* weight, int count,
+                juce::Rectangle<float> bounds, float cellSize);
+
+    // Calls callback (i, j) once for every pair of bodies in the same or neighbouring cells,
+    // which includes every pair closer than the cell size
+    template <typename Callback>
+    void forEachNearbyPair (Callback&& callback) const
+    {
+        // Own cell, then the half of the neighbours after it, so each pair comes up once
+        constexpr int neighbourOffsets[][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+        for (int row = 0; row < numRows; ++row)
+        {
+            for (int column = 0; column < numColumns; ++column)
+            {
+                const int cell = row * numColumns + column;
+
+                for (int a = cellStart[static_cast<size_t>(cell)]; a < cellStart[static_cast<size_t>(cell + 1)]; ++a)
+                {
+                    const int i = sortedBodies[static_cast<size_t>(a)];
+
+                    for (int b = a + 1; b < cellStart[static_cast<size_t>(cell + 1)]; ++b)
+                        callback (i, sortedBodies[static_cast<size_t>(b)]);
+
+                    for (const auto& offset : neighbourOffsets)
+                    {
+                        const int otherColumn = column + offset[0];
+                        const int otherRow = row + offset[1];
+
+                        if (! juce::isPositiveAndBelow (otherColumn, numColumns) || otherRow >= numRows)
+                            continue;
+
+                        const int other = otherRow * numColumns + otherColumn;
+
+                        for (int b = cellStart[static_cast<size_t>(other)]; b < cellStart[static_cast<size_t>(other + 1)]; ++b)
+                            callback (i, sortedBodies[static_cast<size_t>(b)]);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    int numColumns = 0, numRows = 0;
+    std::vector<int> cellStart;      // Bodies in cell c are sortedBodies[cellStart[c] .. cellStart[c + 1])
+    std::vector<int> sortedBodies;
+    std::vector<int> bodyCell;       // Cell of each body, or -1 if it was left out
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpatialHash)
+};
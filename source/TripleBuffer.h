@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// Wait-free hand-over of the latest value from one writer thread to one reader thread.
+// The writer fills its buffer and publishes it; the reader picks up the newest published
+// buffer whenever it likes. Neither ever waits for the other, and a reader that falls
+// behind just skips to the latest value.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer only
+    T& getWriteBuffer() { return buffers[static_cast<size_t>(writeIndex)]; }
+
+    void publish()
+    {
+        writeIndex = shared.exchange (writeIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader only. Switches to the newest published buffer, if there is one since the last
+    // call, and returns the reader's buffer.
+    const T& read()
+    {
+        if ((shared.load (std::memory_order_relaxed) & freshFlag) != 0)
+            readIndex = shared.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+
+        return buffers[static_cast<size_t>(readIndex)];
+    }
+
+    // Not thread safe: for setting every buffer up before the threads start
+    template <typename Callback>
+    void forEachBuffer (Callback&& callback)
+    {
+        for (auto& buffer : buffers)
+            callback (buffer);
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<T, 3> buffers {};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> shared { 2 };   // The buffer in between, plus freshFlag if it's unread
+};
@@ -0,0 +1,116 @@
+#include <BarnesHutTree.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    struct Bodies
+    {
+        std::vector<float> x, y, mass;
+    };
+
+    Bodies makeCluster (int count)
+    {
+        juce::Random random (7);
+        Bodies bodies;
+
+        for (int i = 0; i < count; ++i)
+        {
+            bodies.x.push_back (random.nextFloat() * 400.0f);
+            bodies.y.push_back (random.nextFloat() * 400.0f);
+            bodies.mass.push_back (0.1f + 0.9f * random.nextFloat());
+        }
+
+        return bodies;
+    }
+
+    // Pull on each body from a BarnesHutTree at the given opening angle
+    std::vector<juce::Point<float>> treeAccelerations (const Bodies& bodies, float openingAngle)
+    {
+        const int count = static_cast<int>(bodies.x.size());
+        std::vector<float> ax (bodies.x.size()), ay (bodies.x.size());
+
+        BarnesHutTree tree;
+        tree.reserve (count);
+        tree.build (bodies.x.data(), bodies.y.data(), bodies.mass.data(), count);
+        tree.addAccelerations (bodies.x.data(), bodies.y.data(), bodies.mass.data(), ax.data(), ay.data(), count, 1.0f, openingAngle);
+
+        std::vector<juce::Point<float>> accelerations;
+        for (size_t i = 0; i < ax.size(); ++i)
+            accelerations.push_back ({ ax[i], ay[i] });
+
+        return accelerations;
+    }
+
+    std::vector<juce::Point<float>> pairwiseAccelerations (const Bodies& bodies)
+    {
+        std::vector<juce::Point<float>> accelerations (bodies.x.size());
+
+        for (size_t i = 0; i < bodies.x.size(); ++i)
+        {
+            for (size_t j = 0; j < bodies.x.size(); ++j)
+            {
+                if (i == j)
+                    continue;
+
+                const double dx = bodies.x[j] - bodies.x[i];
+                const double dy = bodies.y[j] - bodies.y[i];
+                const double distance = std::sqrt (dx * dx + dy * dy + BarnesHutTree::softeningSquared);
+                const double scale = bodies.mass[j] / (distance * distance * distance);
+                accelerations[i] += { static_cast<float> (dx * scale), static_cast<float> (dy * scale) };
+            }
+        }
+
+        return accelerations;
+    }
+
+    // Total error over total pull, so bodies whose pulls nearly cancel don't dominate
+    float relativeError (const std::vector<juce::Point<float>>& actual, const std::vector<juce::Point<float>>& expected)
+    {
+        float error = 0.0f, total = 0.0f;
+
+        for (size_t i = 0; i < actual.size(); ++i)
+        {
+            error += (actual[i] - expected[i]).getDistanceFromOrigin();
+            total += expected[i].getDistanceFromOrigin();
+        }
+
+        return error / total;
+    }
+}
+
+TEST_CASE ("Barnes-Hut matches the pairwise sum", "[physics]")
+{
+    const auto bodies = makeCluster (300);
+    const auto exact = pairwiseAccelerations (bodies);
+
+    // Opening every node visits every other body once
+    CHECK (relativeError (treeAccelerations (bodies, 0.0f), exact) < 1.0e-5f);
+
+    // The default opening angle stays within a couple of percent overall
+    CHECK (relativeError (treeAccelerations (bodies, 0.5f), exact) < 0.02f);
+}
+
+TEST_CASE ("Barnes-Hut copes with bodies on top of each other", "[physics]")
+{
+    Bodies bodies;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        bodies.x.push_back (100.0f);
+        bodies.y.push_back (100.0f);
+        bodies.mass.push_back (1.0f);
+    }
+
+    bodies.x.push_back (200.0f);
+    bodies.y.push_back (100.0f);
+    bodies.mass.push_back (1.0f);
+
+    const auto accelerations = treeAccelerations (bodies, 0.5f);
+    const auto exact = pairwiseAccelerations (bodies);
+
+    for (size_t i = 0; i < accelerations.size(); ++i)
+    {
+        CHECK (std::isfinite (accelerations[i].x));
+        CHECK (std::abs (accelerations[i].x - exact[i].x) <= 1.0e-3f * std::abs (exact[i].x) + 1.0e-7f);
+    }
+}
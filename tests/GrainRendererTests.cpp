@@ -0,0 +1,204 @@
+#include <GrainRenderer.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+namespace
+{
+    struct RenderResult
+    {
+        std::vector<float> left;
+        std::vector<float> right;
+    };
+
+    RenderResult renderGrain (GrainRenderer::InstructionSet instructionSet, const std::vector<float>& renderBuffer,
+                              GrainRenderer::Interpolation interpolation,
+                              float pitchShift, int numSamples, bool stereoOutput, float gain)
+    {
+        juce::Random random (1234);
+
+        std::vector<float> grainEnvelope (static_cast<size_t> (numSamples));
+        std::vector<float> adsrEnvelope (static_cast<size_t> (numSamples));
+        for (size_t i = 0; i < grainEnvelope.size(); ++i)
+        {
+            grainEnvelope[i] = random.nextFloat();
+            adsrEnvelope[i] = random.nextFloat();
+        }
+
+        const auto source = GrainRenderer::getSource (renderBuffer);
+
+        GrainRenderer::GrainBlock grain;
+        grain.startSample = static_cast<float> (source.numSamples - 40);
+        grain.playbackPosition = 17;
+        grain.pitchShift = pitchShift;
+        grain.interpolation = interpolation;
+        grain.grainEnvelope = grainEnvelope.data();
+        grain.adsrEnvelope = adsrEnvelope.data();
+        grain.start = { gain * 0.5f, 0.6f, 0.8f };
+        grain.end = { gain, 0.8f, 0.6f };
+        grain.rampSamples = numSamples + 3;
+        grain.numSamples = numSamples;
+
+        // Start from non-zero output to check the kernel accumulates
+        RenderResult result;
+        result.left.assign (static_cast<size_t> (numSamples), 0.25f);
+        result.right.assign (static_cast<size_t> (numSamples), -0.25f);
+
+        GrainRenderer::renderWith (instructionSet, source, grain, result.left.data(),
+                                   stereoOutput ? result.right.data() : nullptr);
+        return result;
+    }
+}
+
+TEST_CASE ("Vector grain kernels match the scalar reference", "[grain-renderer]")
+{
+    const auto pitchShift = GENERATE (1.0f, 0.5f, 1.37f, 8.0f);
+    const auto numSamples = GENERATE (1, 7, 64, 509);
+    const auto numChannels = GENERATE (1, 2);
+    const auto gain = GENERATE (0.5f, 4.0f); // 4.0 drives the soft clipper
+    const auto interpolation = GENERATE (GrainRenderer::Interpolation::Linear,
+                                         GrainRenderer::Interpolation::Hermite,
+                                         GrainRenderer::Interpolation::Sinc);
+
+    juce::Random random (42);
+    juce::AudioBuffer<float> audio (numChannels, 1000);
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            audio.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+    std::vector<float> renderBuffer;
+    GrainRenderer::buildRenderBuffer (audio, renderBuffer);
+
+    const auto reference = renderGrain (GrainRenderer::InstructionSet::Scalar, renderBuffer, interpolation, pitchShift, numSamples, true, gain);
+
+    for (auto instructionSet : { GrainRenderer::InstructionSet::SSE,
+                                 GrainRenderer::InstructionSet::AVX,
+                                 GrainRenderer::InstructionSet::NEON })
+    {
+        if (! GrainRenderer::isSupported (instructionSet))
+            continue;
+
+        INFO (GrainRenderer::getName (instructionSet));
+
+        for (bool stereoOutput : { true, false })
+        {
+            const auto result = renderGrain (instructionSet, renderBuffer, interpolation, pitchShift, numSamples, stereoOutput, gain);
+
+            float maxDifference = 0.0f;
+            for (size_t i = 0; i < reference.left.size(); ++i)
+            {
+                maxDifference = juce::jmax (maxDifference, std::abs (result.left[i] - reference.left[i]));
+
+                if (stereoOutput)
+                    maxDifference = juce::jmax (maxDifference, std::abs (result.right[i] - reference.right[i]));
+            }
+
+            CHECK (maxDifference < 1.0e-5f);
+
+            if (! stereoOutput)
+                CHECK (result.right == std::vector<float> (reference.right.size(), -0.25f));
+        }
+    }
+}
+
+TEST_CASE ("Render buffer is a guard-padded mono mixdown", "[grain-renderer]")
+{
+    juce::AudioBuffer<float> audio (2, 6);
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+    {
+        audio.setSample (0, i, static_cast<float> (i));
+        audio.setSample (1, i, static_cast<float> (i) + 2.0f);
+    }
+
+    std::vector<float> renderBuffer;
+    GrainRenderer::buildRenderBuffer (audio, renderBuffer);
+    const auto source = GrainRenderer::getSource (renderBuffer);
+
+    REQUIRE (source.numSamples == 6);
+
+    for (int i = -GrainRenderer::guardSamples; i < source.numSamples + GrainRenderer::guardSamples; ++i)
+    {
+        const int wrapped = (i + source.numSamples) % source.numSamples;
+        CHECK (source.samples[i] == static_cast<float> (wrapped) + 1.0f);
+    }
+}
+
+TEST_CASE ("Interpolation modes reproduce a slow sine", "[grain-renderer]")
+{
+    juce::AudioBuffer<float> audio (1, 2000);
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+        audio.setSample (0, i, 0.5f * std::sin (static_cast<float> (i) * 0.05f)); // Below the soft clipper
+
+    std::vector<float> renderBuffer;
+    GrainRenderer::buildRenderBuffer (audio, renderBuffer);
+    const auto source = GrainRenderer::getSource (renderBuffer);
+
+    constexpr int numSamples = 256;
+    const std::vector<float> ones (numSamples, 1.0f);
+
+    GrainRenderer::GrainBlock grain;
+    grain.startSample = 100.25f;
+    grain.pitchShift = 0.73f;
+    grain.grainEnvelope = ones.data();
+    grain.adsrEnvelope = ones.data();
+    grain.start = { 1.0f, 1.0f, 0.0f };
+    grain.end = grain.start;
+    grain.numSamples = numSamples;
+
+    for (auto interpolation : { GrainRenderer::Interpolation::Linear,
+                                GrainRenderer::Interpolation::Hermite,
+                                GrainRenderer::Interpolation::Sinc })
+    {
+        grain.interpolation = interpolation;
+
+        std::vector<float> output (numSamples, 0.0f);
+        GrainRenderer::renderWith (GrainRenderer::InstructionSet::Scalar, source, grain, output.data(), nullptr);
+
+        float maxError = 0.0f;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float position = grain.startSample + static_cast<float> (i) * grain.pitchShift;
+            maxError = juce::jmax (maxError, std::abs (output[static_cast<size_t> (i)] - 0.5f * std::sin (position * 0.05f)));
+        }
+
+        CHECK (maxError < 1.0e-3f);
+    }
+}
+
+TEST_CASE ("Gains ramp linearly from start to end", "[grain-renderer]")
+{
+    juce::AudioBuffer<float> audio (1, 100);
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+        audio.setSample (0, i, 0.5f);
+
+    std::vector<float> renderBuffer;
+    GrainRenderer::buildRenderBuffer (audio, renderBuffer);
+
+    constexpr int numSamples = 37;
+    const std::vector<float> ones (numSamples, 1.0f);
+
+    GrainRenderer::GrainBlock grain;
+    grain.grainEnvelope = ones.data();
+    grain.adsrEnvelope = ones.data();
+    grain.start = { 0.0f, 1.0f, 1.0f };
+    grain.end = { 1.0f, 1.0f, 0.0f };
+    grain.rampSamples = numSamples;
+    grain.numSamples = numSamples;
+
+    std::vector<float> left (numSamples, 0.0f);
+    std::vector<float> right (numSamples, 0.0f);
+    GrainRenderer::render (GrainRenderer::getSource (renderBuffer), grain, left.data(), right.data());
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float ramp = static_cast<float> (i + 1) / static_cast<float> (numSamples);
+        CHECK (left[static_cast<size_t> (i)] == Catch::Approx (0.5f * ramp).margin (1.0e-6));
+        CHECK (right[static_cast<size_t> (i)] == Catch::Approx (0.0f).margin (1.0e-6));
+    }
+}
+
+TEST_CASE ("Active instruction set is supported", "[grain-renderer]")
+{
+    CHECK (GrainRenderer::isSupported (GrainRenderer::getActiveInstructionSet()));
+    CHECK (GrainRenderer::isSupported (GrainRenderer::InstructionSet::Scalar));
+}
@@ -0,0 +1,39 @@
+#include <GravityField.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE ("Cached gravity field matches the exact pull away from the masses", "[physics]")
+{
+    const ParticlePhysics::Mass masses[] = { { { 120.0f, 150.0f }, 2.0f }, { { 300.0f, 260.0f }, 4.0f }, { { 90.0f, 340.0f }, 1.0f } };
+
+    GravityField field;
+    field.setMasses (masses, 3, { 0.0f, 0.0f, 400.0f, 400.0f });
+
+    // Built incrementally, and unusable until the last row is in
+    CHECK_FALSE (field.buildRows (GravityField::resolution / 2));
+    CHECK (field.buildRows (GravityField::resolution));
+
+    juce::Random random (42);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const juce::Point<float> position (random.nextFloat() * 400.0f, random.nextFloat() * 400.0f);
+
+        juce::Point<float> exact;
+        float nearest = std::numeric_limits<float>::max();
+
+        for (const auto& mass : masses)
+        {
+            const auto d = mass.position - position;
+            const float distance = d.getDistanceFromOrigin();
+            exact += d * (mass.strength / (distance * distance * distance));
+            nearest = std::min (nearest, distance);
+        }
+
+        if (nearest < 30.0f)
+            continue;
+
+        INFO ("At " << position.x << ", " << position.y);
+        const auto error = (field.sample (position).acceleration - exact).getDistanceFromOrigin();
+        CHECK (error < 0.03f * exact.getDistanceFromOrigin() + 1.0e-6f);
+    }
+}
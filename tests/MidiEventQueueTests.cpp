@@ -0,0 +1,97 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+TEST_CASE ("MIDI event queue hands events across threads in order", "[midi]")
+{
+    MidiEventQueue queue;
+    constexpr int numEvents = 100000;
+
+    std::thread producer ([&]
+    {
+        for (int i = 0; i < numEvents; ++i)
+            while (! queue.push (juce::MidiMessage::noteOn (1, i % 128, static_cast<juce::uint8> (1 + i % 127)), i))
+                std::this_thread::yield();
+    });
+
+    int received = 0;
+    bool inOrder = true;
+
+    while (received < numEvents)
+    {
+        if (auto* event = queue.front())
+        {
+            inOrder = inOrder && event->samplePosition == received && event->toMessage().getNoteNumber() == received % 128;
+            queue.pop();
+            ++received;
+        }
+    }
+
+    producer.join();
+
+    CHECK (inOrder);
+    CHECK (queue.front() == nullptr);
+}
+
+TEST_CASE ("MIDI event queue refuses events when full", "[midi]")
+{
+    MidiEventQueue queue;
+
+    for (size_t i = 0; i < MidiEventQueue::capacity; ++i)
+        REQUIRE (queue.push (juce::MidiMessage::noteOff (1, 60), 0));
+
+    CHECK_FALSE (queue.push (juce::MidiMessage::noteOff (1, 60), 0));
+
+    queue.pop();
+    CHECK (queue.push (juce::MidiMessage::noteOff (1, 60), 0));
+}
+
+TEST_CASE ("Scheduled UI notes play in the block they fall in", "[midi]")
+{
+    constexpr int blockSize = 128;
+
+    PluginProcessor plugin;
+    plugin.prepareToPlay (48000.0, blockSize);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+
+    plugin.processBlock (buffer, midi);
+    REQUIRE (plugin.getSamplePosition() == blockSize);
+
+    // Due 2.5 blocks from now: the third block from here plays it
+    plugin.scheduleMidiMessage (juce::MidiMessage::noteOn (1, 60, 0.8f), plugin.getSamplePosition() + blockSize * 5 / 2);
+
+    for (int block = 0; block < 3; ++block)
+    {
+        CHECK (plugin.getParticles()->empty());
+        plugin.processBlock (buffer, midi);
+    }
+
+    CHECK (plugin.getParticles()->size() == 1);
+    plugin.releaseResources();
+}
+
+TEST_CASE ("Injected UI notes don't wait behind notes scheduled later", "[midi]")
+{
+    constexpr int blockSize = 128;
+
+    PluginProcessor plugin;
+    plugin.prepareToPlay (48000.0, blockSize);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+
+    // A sequencer note-on two seconds out, then a key pressed now
+    plugin.scheduleMidiMessage (juce::MidiMessage::noteOn (1, 48, 0.8f), plugin.getSamplePosition() + 96000);
+    plugin.injectMidiMessage (juce::MidiMessage::noteOn (1, 60, 0.8f));
+
+    plugin.processBlock (buffer, midi);
+    CHECK (plugin.getParticles()->size() == 1);
+
+    for (int block = 0; block < 96000 / blockSize; ++block)
+        plugin.processBlock (buffer, midi);
+
+    CHECK (plugin.getParticles()->size() == 2);
+    plugin.releaseResources();
+}
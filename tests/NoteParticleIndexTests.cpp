@@ -0,0 +1,58 @@
+#include <Particle.h>
+#include <catch2/catch_test_macros.hpp>
+#include <set>
+
+namespace
+{
+    std::set<Particle*> particlesOn (const NoteParticleIndex& index, int noteNumber)
+    {
+        std::set<Particle*> found;
+        index.forEachParticle (noteNumber, [&] (Particle& particle) { found.insert (&particle); });
+        return found;
+    }
+}
+
+TEST_CASE ("Note index tracks particles per note", "[particle]")
+{
+    const juce::Rectangle<float> bounds (0.0f, 0.0f, 400.0f, 400.0f);
+    std::vector<std::unique_ptr<Particle>> particles;
+
+    for (int note : { 60, 64, 60, 60, 200 })
+        particles.push_back (std::make_unique<Particle> (juce::Point<float>(), juce::Point<float>(), bounds, note, 0.01f, 0.7f, 0.7f, 0.5f));
+
+    NoteParticleIndex index;
+    for (auto& particle : particles)
+        index.add (*particle);
+
+    CHECK (particlesOn (index, 60) == std::set<Particle*> { particles[0].get(), particles[2].get(), particles[3].get() });
+    CHECK (particlesOn (index, 64) == std::set<Particle*> { particles[1].get() });
+    CHECK (particlesOn (index, 61).empty());
+
+    // Head, middle and out-of-range removals
+    index.remove (*particles[3]);
+    index.remove (*particles[0]);
+    index.remove (*particles[4]);
+    CHECK (particlesOn (index, 60) == std::set<Particle*> { particles[2].get() });
+
+    // Removing from inside the visit is allowed
+    index.add (*particles[0]);
+    index.forEachParticle (60, [&] (Particle& particle) { index.remove (particle); });
+    CHECK (particlesOn (index, 60).empty());
+    CHECK (particlesOn (index, 64).size() == 1);
+
+    index.clear();
+    CHECK (particlesOn (index, 64).empty());
+}
+
+TEST_CASE ("Particles keep their unique ID when respawned", "[particle]")
+{
+    const juce::Rectangle<float> bounds (0.0f, 0.0f, 400.0f, 400.0f);
+    Particle first ({}, {}, bounds, 60, 0.01f, 0.7f, 0.7f, 0.5f);
+    Particle second ({}, {}, bounds, 60, 0.01f, 0.7f, 0.7f, 0.5f);
+
+    CHECK (first.getUniqueID() != second.getUniqueID());
+
+    const int id = first.getUniqueID();
+    first.respawn ({ 10.0f, 10.0f }, {}, bounds, 72, 0.01f, 0.7f, 0.7f, 0.5f);
+    CHECK (first.getUniqueID() == id);
+}
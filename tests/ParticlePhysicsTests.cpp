@@ -0,0 +1,195 @@
+#include <Particle.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace
+{
+    constexpr float strength = 100000.0f;
+    const juce::Point<float> centre { 200.0f, 200.0f };
+
+    double orbitalEnergy (const ParticlePhysics& physics, size_t i)
+    {
+        const double dx = physics.x[i] - centre.x;
+        const double dy = physics.y[i] - centre.y;
+        const double speedSquared = physics.vx[i] * physics.vx[i] + physics.vy[i] * physics.vy[i];
+        return 0.5 * speedSquared - strength / std::sqrt (dx * dx + dy * dy);
+    }
+
+    // Worst relative energy error over a ring of circular orbits after 20 s at a coarse step
+    double energyDrift (ParticlePhysics::Integrator integrator)
+    {
+        constexpr int numBodies = 32;
+        constexpr float deltaTime = 0.02f;
+
+        ParticlePhysics physics (numBodies);
+        std::vector<std::unique_ptr<Particle>> particles;
+
+        for (int i = 0; i < numBodies; ++i)
+        {
+            const float radius = 20.0f + 4.0f * static_cast<float> (i);
+            const float angle = 2.4f * static_cast<float> (i);
+            const float speed = std::sqrt (strength / radius);
+
+            particles.push_back (std::make_unique<Particle> (centre + juce::Point<float> (std::cos (angle), std::sin (angle)) * radius,
+                                                             juce::Point<float> (-std::sin (angle), std::cos (angle)) * speed,
+                                                             juce::Rectangle<float> (0.0f, 0.0f, 400.0f, 400.0f),
+                                                             60, 0.01f, 0.7f, 0.7f, 0.5f));
+            physics.addBody (*particles.back());
+        }
+
+        std::vector<double> initialEnergy;
+        for (size_t i = 0; i < numBodies; ++i)
+            initialEnergy.push_back (orbitalEnergy (physics, i));
+
+        const ParticlePhysics::Mass mass { centre, strength };
+        for (int step = 0; step < 1000; ++step)
+            physics.step (deltaTime, integrator, &mass, 1);
+
+        double drift = 0.0;
+        for (size_t i = 0; i < numBodies; ++i)
+            drift = std::max (drift, std::abs ((orbitalEnergy (physics, i) - initialEnergy[i]) / initialEnergy[i]));
+
+        return drift;
+    }
+}
+
+TEST_CASE ("Higher-order integrators hold closed orbits at large steps", "[physics]")
+{
+    const auto euler = energyDrift (ParticlePhysics::Integrator::Euler);
+    const auto verlet = energyDrift (ParticlePhysics::Integrator::VelocityVerlet);
+    const auto rk4 = energyDrift (ParticlePhysics::Integrator::RK4);
+
+    CHECK (verlet < 1.0e-3);
+    CHECK (rk4 < 1.0e-3);
+    CHECK (verlet < euler);
+    CHECK (rk4 < euler);
+}
+
+TEST_CASE ("Removing a body keeps the others bound to their state", "[physics]")
+{
+    ParticlePhysics physics (4);
+    std::vector<std::unique_ptr<Particle>> particles;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        particles.push_back (std::make_unique<Particle> (juce::Point<float> (10.0f * static_cast<float> (i), 0.0f), juce::Point<float> (0.0f, static_cast<float> (i)),
+                                                         juce::Rectangle<float> (0.0f, 0.0f, 400.0f, 400.0f), 60, 0.01f, 0.7f, 0.7f, 0.5f));
+        physics.addBody (*particles.back());
+    }
+
+    physics.removeBody (particles[1]->getPhysicsIndex());
+
+    CHECK (physics.getNumBodies() == 3);
+    CHECK (particles[1]->getPosition() == juce::Point<float> (10.0f, 0.0f)); // Kept in its own store
+
+    for (int i : { 0, 2, 3 })
+    {
+        CHECK (particles[(size_t) i]->getPosition() == juce::Point<float> (10.0f * static_cast<float> (i), 0.0f));
+        CHECK (particles[(size_t) i]->getVelocity() == juce::Point<float> (0.0f, static_cast<float> (i)));
+    }
+}
+
+TEST_CASE ("Colliding particles conserve momentum", "[physics]")
+{
+    const juce::Rectangle<float> bounds (0.0f, 0.0f, 400.0f, 400.0f);
+
+    // Heavier particle on the left heading right, lighter one on the right heading left
+    auto collide = [&] (ParticlePhysics::CollisionMode mode, auto&& check)
+    {
+        Particle heavy ({ 100.0f, 100.0f }, { 30.0f, 0.0f }, bounds, 60, 0.01f, 0.7f, 0.7f, 0.5f, 1.0f);
+        Particle light ({ 108.0f, 100.0f }, { -50.0f, 0.0f }, bounds, 62, 0.01f, 0.7f, 0.7f, 0.5f, 0.5f);
+
+        ParticlePhysics physics (2);
+        physics.addBody (heavy);
+        physics.addBody (light);
+
+        CHECK (physics.resolveCollisions (mode, 10.0f, bounds) == 1);
+        check (physics, heavy, light);
+    };
+
+    const float momentum = 1.0f * 30.0f + 0.5f * -50.0f;
+
+    SECTION ("Bounce")
+    {
+        collide (ParticlePhysics::CollisionMode::Bounce, [&] (ParticlePhysics& physics, Particle& heavy, Particle& light)
+        {
+            CHECK (heavy.getVelocity().x * 1.0f + light.getVelocity().x * 0.5f == Catch::Approx (momentum));
+
+            const float energy = 0.5f * (1.0f * 30.0f * 30.0f + 0.5f * 50.0f * 50.0f);
+            CHECK (0.5f * (1.0f * heavy.getVelocity().x * heavy.getVelocity().x + 0.5f * light.getVelocity().x * light.getVelocity().x)
+                   == Catch::Approx (energy));
+
+            // Separating now, so a second pass leaves them alone
+            CHECK (light.getVelocity().x > heavy.getVelocity().x);
+            CHECK (physics.resolveCollisions (ParticlePhysics::CollisionMode::Bounce, 10.0f, bounds) == 0);
+        });
+    }
+
+    SECTION ("Merge")
+    {
+        collide (ParticlePhysics::CollisionMode::Merge, [&] (ParticlePhysics& physics, Particle& heavy, Particle& light)
+        {
+            CHECK (physics.mass[(size_t) heavy.getPhysicsIndex()] == Catch::Approx (1.5f));
+            CHECK (heavy.getInitialVelocityMultiplier() == Catch::Approx (1.5f));   // Grains carry the merged mass
+            CHECK (heavy.getVelocity().x * 1.5f == Catch::Approx (momentum));
+            CHECK (light.getADSRPhase() == ADSRPhase::Release);
+            CHECK (physics.resolveCollisions (ParticlePhysics::CollisionMode::Merge, 10.0f, bounds) == 0);
+        });
+    }
+}
+
+TEST_CASE ("Vector gravity matches the scalar gravity", "[physics]")
+{
+    const juce::Point<float> mass { 200.0f, 150.0f };
+    juce::Random random (12);
+
+    // Counts that leave a scalar tail after the four-wide loop, including none at all
+    for (int count : { 1, 3, 4, 5, 7, 13, 31 })
+    {
+        std::vector<float> px, py;
+
+        for (int i = 0; i < count; ++i)
+        {
+            // Every third body sits on an axis just inside, on or just outside the cutoff, so
+            // it lands in both the vector lanes and the tail
+            if (i % 3 == 0)
+            {
+                const float distance = (i / 3) % 3 == 0 ? 4.99f : (i / 3) % 3 == 1 ? 5.0f : 5.01f;
+                const bool horizontal = (i / 9) % 2 == 0;
+                px.push_back (mass.x + (horizontal ? distance : 0.0f));
+                py.push_back (mass.y + (horizontal ? 0.0f : -distance));
+            }
+            else
+            {
+                px.push_back (random.nextFloat() * 400.0f);
+                py.push_back (random.nextFloat() * 400.0f);
+            }
+        }
+
+        std::vector<float> vectorX (px.size(), 0.0f), vectorY (px.size(), 0.0f);
+        std::vector<float> scalarX (px.size(), 0.0f), scalarY (px.size(), 0.0f);
+
+        ParticlePhysics::addGravity (px.data(), py.data(), vectorX.data(), vectorY.data(), count, mass, strength);
+        ParticlePhysics::addGravityScalar (px.data(), py.data(), scalarX.data(), scalarY.data(), count, mass, strength);
+
+        for (size_t i = 0; i < px.size(); ++i)
+        {
+            const float dx = mass.x - px[i];
+            const float dy = mass.y - py[i];
+
+            if (dx * dx + dy * dy <= ParticlePhysics::minMassDistanceSquared)
+            {
+                CHECK (vectorX[i] == 0.0f);
+                CHECK (vectorY[i] == 0.0f);
+                CHECK (scalarX[i] == 0.0f);
+                CHECK (scalarY[i] == 0.0f);
+            }
+            else
+            {
+                CHECK (scalarX[i] * scalarX[i] + scalarY[i] * scalarY[i] > 0.0f);
+                CHECK (vectorX[i] == Catch::Approx (scalarX[i]).epsilon (2.0e-6));
+                CHECK (vectorY[i] == Catch::Approx (scalarY[i]).epsilon (2.0e-6));
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include <ParticlePool.h>
+#include <catch2/catch_test_macros.hpp>
+#include <set>
+
+TEST_CASE ("Particle pool recycles its slots", "[particle]")
+{
+    ParticlePool pool;
+    pool.reserve (4);
+    REQUIRE (pool.getCapacity() == 4);
+
+    std::set<Particle*> acquired;
+    for (int i = 0; i < 4; ++i)
+        acquired.insert (pool.acquire());
+
+    CHECK (acquired.size() == 4);
+    CHECK (acquired.count (nullptr) == 0);
+    CHECK (pool.acquire() == nullptr);
+
+    // A released particle is the next one handed out
+    auto* released = *acquired.begin();
+    pool.release (released);
+    CHECK (pool.getNumFree() == 1);
+    CHECK (pool.acquire() == released);
+
+    // Growing keeps the particles already handed out
+    pool.reserve (6);
+    CHECK (pool.getCapacity() == 6);
+    CHECK (pool.getNumFree() == 2);
+    CHECK (acquired.count (pool.acquire()) == 0);
+}
+
+TEST_CASE ("Grains past the per-particle limit steal the oldest", "[particle]")
+{
+    Particle particle ({ 100.0f, 100.0f }, {}, { 0.0f, 0.0f, 400.0f, 400.0f }, 60, 0.01f, 0.7f, 0.7f, 0.5f);
+    particle.updateSampleRate (48000.0);
+
+    for (int i = 0; i < Particle::MAX_GRAINS_PER_PARTICLE + 3; ++i)
+    {
+        particle.triggerNewGrain (48000, 0, 0.0f);
+        particle.updateGrains (16);
+    }
+
+    const auto& grains = particle.getActiveGrains();
+    REQUIRE (grains.size() == static_cast<size_t> (Particle::MAX_GRAINS_PER_PARTICLE));
+
+    // The survivors are the newest, so none has played for longer than the limit allows
+    for (const auto& grain : grains)
+        CHECK (grain.playbackPosition <= 16 * Particle::MAX_GRAINS_PER_PARTICLE);
+}
@@ -0,0 +1,195 @@
+#include <Particle.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace
+{
+    constexpr float grainFrequency = 17.3f;
+
+    struct GrainStart
+    {
+        int sample;
+        float subSampleDelay;
+    };
+
+    // Exact start time of every grain a particle triggers over numSamples, run at the given block size
+    std::vector<GrainStart> scheduleGrains (int blockSize, int numSamples)
+    {
+        Particle particle ({ 100.0f, 100.0f }, {}, { 0.0f, 0.0f, 400.0f, 400.0f }, 60, 0.01f, 0.7f, 0.7f, 0.5f);
+        particle.updateSampleRate (48000.0);
+        particle.setGrainParameters (20.0f, 0.0f, 0.0f);
+
+        std::vector<GrainStart> starts;
+
+        for (int blockStart = 0; blockStart < numSamples; blockStart += blockSize)
+        {
+            particle.scheduleGrains (48000.0, grainFrequency, blockSize, 48000);
+
+            for (const auto& grain : particle.getActiveGrains())
+                if (grain.playbackPosition == 0)
+                    starts.push_back ({ blockStart + grain.blockOffset, grain.subSampleDelay });
+
+            particle.updateGrains (blockSize);
+        }
+
+        return starts;
+    }
+}
+
+TEST_CASE ("Grain timing doesn't depend on block size", "[particle]")
+{
+    constexpr int numSamples = 48000;
+    const auto reference = scheduleGrains (1, numSamples);
+
+    // 17.3 Hz at 48 kHz: one grain every 2774.57 samples, starting at sample 0
+    REQUIRE (reference.size() == 18);
+
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        const double exactTime = static_cast<double> (i) * 48000.0 / static_cast<double> (grainFrequency);
+        CHECK (static_cast<double> (reference[i].sample) - reference[i].subSampleDelay == Catch::Approx (exactTime).margin (1.0e-3));
+    }
+
+    for (int blockSize : { 64, 1000, 1024, 4096 })
+    {
+        INFO ("Block size " << blockSize);
+        const auto starts = scheduleGrains (blockSize, numSamples);
+
+        REQUIRE (starts.size() == reference.size());
+
+        for (size_t i = 0; i < reference.size(); ++i)
+        {
+            CHECK (starts[i].sample == reference[i].sample);
+            CHECK (starts[i].subSampleDelay == Catch::Approx (reference[i].subSampleDelay).margin (1.0e-4));
+        }
+    }
+}
+
+namespace
+{
+    // The per-sample window the grain renderer used before renderGrainEnvelope, with an exact Hann
+    float referenceGrainAmplitude (int grainPos, int grainTotalSamples, int cachedTotalGrainSamples, double sampleRate)
+    {
+        if (grainTotalSamples <= 0 || grainPos >= cachedTotalGrainSamples)
+            return 0.0f;
+
+        const int fadeSamples = static_cast<int> (0.010f * sampleRate);
+        const int fade = juce::jmin (fadeSamples, grainTotalSamples / 2);
+        auto hann = [] (float position) { return 0.5f * (1.0f - std::cos (juce::MathConstants<float>::twoPi * juce::jlimit (0.0f, 1.0f, position))); };
+
+        if (grainPos < fade)
+            return hann (0.5f * juce::jlimit (0.0f, 1.0f, static_cast<float> (grainPos) / static_cast<float> (fade - 1)));
+
+        if (grainPos >= grainTotalSamples - fade)
+        {
+            const int samplesToEnd = grainTotalSamples - grainPos;
+            const float progress = 1.0f - static_cast<float> (samplesToEnd - 1) / static_cast<float> (fade - 1);
+            return hann (0.5f + 0.5f * juce::jlimit (0.0f, 1.0f, progress));
+        }
+
+        return 1.0f;
+    }
+
+    // One particle's ADSR output, rendered in blocks or stepped a sample at a time as before
+    // renderADSRBlock, with the release triggered at releaseSample
+    std::vector<float> renderADSR (bool inBlocks, float attack, int releaseSample, int numSamples)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 96;
+
+        Particle particle ({ 100.0f, 100.0f }, {}, { 0.0f, 0.0f, 400.0f, 400.0f }, 60, attack, 0.6f, 0.7f, 0.1f);
+        particle.updateSampleRate (sampleRate);
+
+        std::vector<float> output (static_cast<size_t> (numSamples));
+        const float coefficient = 1.0f - std::exp (-2.2f / (0.0005f * static_cast<float> (sampleRate)));
+        float smoothed = 0.0f;
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            if (position == releaseSample)
+                particle.triggerRelease();
+
+            if (inBlocks)
+            {
+                particle.renderADSRBlock (output.data() + position, blockSize);
+                continue;
+            }
+
+            for (int i = position; i < position + blockSize; ++i)
+            {
+                particle.updateADSR (static_cast<float> (1.0 / sampleRate));
+                smoothed += coefficient * (particle.getADSRAmplitude() - smoothed);
+                output[static_cast<size_t> (i)] = smoothed;
+            }
+        }
+
+        return output;
+    }
+}
+
+TEST_CASE ("Grain window matches the per-sample window", "[particle]")
+{
+    constexpr double sampleRate = 48000.0;
+    Particle::initializeHannTable();
+
+    // 20 ms has a flat middle between 10 ms fades; 5 ms is all fade and shorter than a block
+    for (float grainMs : { 20.0f, 5.0f })
+    {
+        Particle particle ({ 100.0f, 100.0f }, {}, { 0.0f, 0.0f, 400.0f, 400.0f }, 60, 0.01f, 0.7f, 0.7f, 0.5f);
+        particle.updateSampleRate (sampleRate);
+        particle.setGrainParameters (grainMs, 0.0f, 0.0f);
+
+        Grain grain;
+        grain.totalSamples = particle.getTotalGrainSamples();
+
+        for (int blockSize : { 1, 64, 333, 512 })
+        {
+            INFO ("Grain " << grainMs << " ms, block size " << blockSize);
+
+            // Runs past the end, where the window must be silent
+            const int numSamples = grain.totalSamples + 600;
+            std::vector<float> window (static_cast<size_t> (numSamples + blockSize));
+
+            for (int position = 0; position < numSamples; position += blockSize)
+                particle.renderGrainEnvelope (grain, position, window.data() + position, blockSize);
+
+            float maxError = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+                maxError = std::max (maxError, std::abs (window[static_cast<size_t> (i)]
+                                                         - referenceGrainAmplitude (i, grain.totalSamples, particle.getTotalGrainSamples(), sampleRate)));
+
+            CHECK (maxError < 1.0e-4f);
+
+            bool silentAfterEnd = true;
+            for (int i = grain.totalSamples; i < numSamples; ++i)
+                silentAfterEnd = silentAfterEnd && window[static_cast<size_t> (i)] == 0.0f;
+
+            CHECK (silentAfterEnd);
+        }
+    }
+}
+
+TEST_CASE ("Block ADSR matches the per-sample envelope", "[particle]")
+{
+    constexpr int numSamples = 48000;
+
+    // Attack, decay and sustain, then a full release; and a release cut in mid-attack
+    const std::pair<float, int> cases[] = { { 0.05f, 24000 }, { 0.2f, 2400 } };
+
+    for (const auto& [attack, releaseSample] : cases)
+    {
+        INFO ("Attack " << attack << " s, release at sample " << releaseSample);
+
+        const auto block = renderADSR (true, attack, releaseSample, numSamples);
+        const auto reference = renderADSR (false, attack, releaseSample, numSamples);
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < block.size(); ++i)
+            maxError = std::max (maxError, std::abs (block[i] - reference[i]));
+
+        CHECK (maxError < 1.0e-4f);
+
+        // Ends fully released
+        CHECK (reference.back() < 1.0e-6f);
+    }
+}
@@ -0,0 +1,91 @@
+#include <RcuObject.h>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+namespace
+{
+    // Every field holds the same value, so reading a freed or half-built object shows up
+    struct Scene
+    {
+        std::vector<int> values = std::vector<int> (32, 0);
+    };
+
+    std::unique_ptr<Scene> makeScene (int value)
+    {
+        auto scene = std::make_unique<Scene>();
+        std::fill (scene->values.begin(), scene->values.end(), value);
+        return scene;
+    }
+}
+
+TEST_CASE ("RCU reader keeps its object until the read ends", "[rcu]")
+{
+    RcuObject<Scene> rcu;
+    rcu.publish (makeScene (1));
+
+    {
+        const RcuObject<Scene>::ReadScope read (rcu);
+        CHECK (read->values.front() == 1);
+
+        // Replaced mid-read: the old object can't be freed yet
+        rcu.publish (makeScene (2));
+        CHECK (read->values.front() == 1);
+        CHECK (rcu.getLatest().values.front() == 2);
+        CHECK (rcu.getNumRetired() == 1);
+    }
+
+    rcu.reclaim();
+    CHECK (rcu.getNumRetired() == 0);
+
+    const RcuObject<Scene>::ReadScope read (rcu);
+    CHECK (read->values.front() == 2);
+}
+
+TEST_CASE ("RCU objects published with no reader active are freed straight away", "[rcu]")
+{
+    RcuObject<Scene> rcu;
+
+    for (int value = 1; value <= 10; ++value)
+        rcu.publish (makeScene (value));
+
+    CHECK (rcu.getNumRetired() == 0);
+    CHECK (rcu.getLatest().values.back() == 10);
+}
+
+TEST_CASE ("RCU reader sees whole, in-order objects while the writer publishes", "[rcu]")
+{
+    constexpr int numScenes = 20000;
+
+    RcuObject<Scene> rcu;
+    std::atomic<bool> done { false };
+
+    std::thread writer ([&]
+    {
+        for (int value = 1; value <= numScenes; ++value)
+            rcu.publish (makeScene (value));
+
+        done = true;
+    });
+
+    int last = 0;
+    bool torn = false;
+    bool wentBackwards = false;
+
+    while (! done || last < numScenes)
+    {
+        const RcuObject<Scene>::ReadScope read (rcu);
+        const int value = read->values.front();
+
+        for (int v : read->values)
+            torn = torn || v != value;
+
+        wentBackwards = wentBackwards || value < last;
+        last = value;
+    }
+
+    writer.join();
+
+    CHECK_FALSE (torn);
+    CHECK_FALSE (wentBackwards);
+    CHECK (last == numScenes);
+}
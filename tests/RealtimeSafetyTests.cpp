@@ -0,0 +1,176 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocator for the test binary. Allocations are only
+// counted on a thread while it is inside a ScopedAllocationCheck.
+namespace
+{
+    thread_local bool checkingAllocations = false;
+    std::atomic<int> allocationCount { 0 };
+    std::atomic<int> deallocationCount { 0 };
+
+    void* allocate (std::size_t size)
+    {
+        if (checkingAllocations)
+            ++allocationCount;
+
+        if (auto* ptr = std::malloc (size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocate (void* ptr) noexcept
+    {
+        if (ptr != nullptr && checkingAllocations)
+            ++deallocationCount;
+
+        std::free (ptr);
+    }
+
+    struct ScopedAllocationCheck
+    {
+        ScopedAllocationCheck() { checkingAllocations = true; }
+        ~ScopedAllocationCheck() { checkingAllocations = false; }
+    };
+}
+
+void* operator new (std::size_t size) { return allocate (size); }
+void* operator new[] (std::size_t size) { return allocate (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept { try { return allocate (size); } catch (...) { return nullptr; } }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { try { return allocate (size); } catch (...) { return nullptr; } }
+void operator delete (void* ptr) noexcept { deallocate (ptr); }
+void operator delete[] (void* ptr) noexcept { deallocate (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { deallocate (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { deallocate (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept { deallocate (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { deallocate (ptr); }
+
+namespace
+{
+    void writeTestFile (const juce::File& file)
+    {
+        juce::AudioBuffer<float> audio (2, 44100);
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+        {
+            const auto sample = 0.5f * std::sin (juce::MathConstants<float>::twoPi * 220.0f * static_cast<float> (i) / 44100.0f);
+            audio.setSample (0, i, sample);
+            audio.setSample (1, i, -sample);
+        }
+
+        juce::WavAudioFormat wav;
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), 44100.0, 2, 16, {}, 0));
+        REQUIRE (writer != nullptr);
+        stream.release(); // Owned by the writer now
+
+        writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    void setParameter (PluginProcessor& plugin, const juce::String& id, float value)
+    {
+        auto* parameter = plugin.getAPVTS().getParameter (id);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    // Plays chords, UI notes and oversized host blocks with the allocation check on each
+    // processBlock call. Returns whether any audio came out.
+    bool runAllocationStress (PluginProcessor& plugin)
+    {
+        constexpr int blockSize = 256;
+        plugin.prepareToPlay (44100.0, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize (4096);
+
+        bool producedAudio = false;
+
+        for (int block = 0; block < 600; ++block)
+        {
+            // Chords that overrun maxParticles, held for a few blocks then released
+            midi.clear();
+            for (int note = 0; note < 6; ++note)
+            {
+                const int noteNumber = 36 + (block * 7 + note * 5) % 60;
+
+                if (block % 4 == 0)
+                    midi.addEvent (juce::MidiMessage::noteOn (1, noteNumber, 0.8f), note * 16);
+                else if (block % 4 == 2)
+                    midi.addEvent (juce::MidiMessage::noteOff (1, 36 + ((block - 2) * 7 + note * 5) % 60), note * 16);
+            }
+
+            // Notes from the on-screen keyboard arrive through the UI queue
+            if (block % 10 == 5)
+            {
+                plugin.injectMidiMessage (juce::MidiMessage::noteOn (1, 72, 1.0f));
+                plugin.injectMidiMessage (juce::MidiMessage::noteOff (1, 72));
+            }
+
+            {
+                ScopedAllocationCheck check;
+                plugin.processBlock (buffer, midi);
+            }
+
+            producedAudio = producedAudio || buffer.getMagnitude (0, 0, blockSize) > 0.0f;
+        }
+
+        // Host blocks longer than the prepared size are split, not handled by growing buffers
+        juce::AudioBuffer<float> longBuffer (2, blockSize * 4 + 37);
+
+        for (int block = 0; block < 40; ++block)
+        {
+            midi.clear();
+            if (block % 4 == 0)
+                midi.addEvent (juce::MidiMessage::noteOn (1, 48 + block % 24, 0.8f), blockSize * 3);
+
+            ScopedAllocationCheck check;
+            plugin.processBlock (longBuffer, midi);
+        }
+
+        plugin.releaseResources();
+        return producedAudio;
+    }
+}
+
+TEST_CASE ("processBlock never allocates", "[realtime]")
+{
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile());
+
+    PluginProcessor plugin;
+    plugin.loadAudioFile (tempFile.getFile());
+    REQUIRE (plugin.waitForAudioFile());
+    REQUIRE (plugin.hasAudioFileLoaded());
+
+    // Short envelopes so particles finish and get recycled during the run
+    plugin.getAPVTS().getParameter ("attack")->setValueNotifyingHost (0.0f);
+    plugin.getAPVTS().getParameter ("release")->setValueNotifyingHost (0.0f);
+
+    SECTION ("Default settings")
+    {
+    }
+
+    // Every per-tick path: the spatial hash and merge releases, the Barnes-Hut build,
+    // the gravity field rebuild, four force evaluations a tick and sinc reads
+    SECTION ("Collisions, mutual gravity, approximate gravity, RK4 and sinc")
+    {
+        setParameter (plugin, "collisions", 2.0f);   // Merge
+        setParameter (plugin, "collisionRadius", 40.0f);
+        setParameter (plugin, "mutualGravity", 0.8f);
+        setParameter (plugin, "gravityField", 1.0f);
+        setParameter (plugin, "integrator", 2.0f);   // RK4
+        setParameter (plugin, "interpolation", 2.0f);   // Sinc
+    }
+
+    allocationCount = 0;
+    deallocationCount = 0;
+
+    CHECK (runAllocationStress (plugin));
+    CHECK (allocationCount.load() == 0);
+    CHECK (deallocationCount.load() == 0);
+}
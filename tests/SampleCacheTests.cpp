@@ -0,0 +1,99 @@
+#include <SampleCache.h>
+#include <SampleLoader.h>
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    SampleCache::Key makeTestKey (const juce::String& path, double renderSampleRate = 44100.0)
+    {
+        SampleCache::Key key;
+        key.path = path;
+        key.renderSampleRate = renderSampleRate;
+        return key;
+    }
+
+    const auto neverStop = [] { return false; };
+}
+
+TEST_CASE ("Sample cache shares a sample while anyone holds it", "[samplecache]")
+{
+    SampleCache cache;
+    int numLoads = 0;
+
+    auto load = [&numLoads]
+    {
+        ++numLoads;
+        return std::make_shared<const LoadedSample>();
+    };
+
+    auto first = cache.getOrLoad (makeTestKey ("a.wav"), load, neverStop);
+    auto second = cache.getOrLoad (makeTestKey ("a.wav"), load, neverStop);
+    REQUIRE (first != nullptr);
+    CHECK (first == second);
+    CHECK (numLoads == 1);
+    CHECK (cache.getNumCachedSamples() == 1);
+
+    // Anything the sample depends on gives a separate entry
+    auto resampled = cache.getOrLoad (makeTestKey ("a.wav", 48000.0), load, neverStop);
+    CHECK (resampled != first);
+    CHECK (numLoads == 2);
+
+    // Freed with its last user, not kept alive by the cache
+    first.reset();
+    second.reset();
+    resampled.reset();
+    CHECK (cache.getNumCachedSamples() == 0);
+
+    cache.getOrLoad (makeTestKey ("a.wav"), load, neverStop);
+    CHECK (numLoads == 3);
+}
+
+TEST_CASE ("Sample cache doesn't keep failed loads", "[samplecache]")
+{
+    SampleCache cache;
+    int numLoads = 0;
+
+    auto failingLoad = [&numLoads]
+    {
+        ++numLoads;
+        return std::shared_ptr<const LoadedSample>();
+    };
+
+    CHECK (cache.getOrLoad (makeTestKey ("bad.wav"), failingLoad, neverStop) == nullptr);
+    CHECK (cache.getOrLoad (makeTestKey ("bad.wav"), failingLoad, neverStop) == nullptr);
+    CHECK (numLoads == 2);
+}
+
+TEST_CASE ("Sample cache decodes a file once when instances load it together", "[samplecache]")
+{
+    constexpr int numThreads = 8;
+
+    SampleCache cache;
+    std::atomic<int> numLoads { 0 };
+    std::vector<std::shared_ptr<const LoadedSample>> results (numThreads);
+
+    auto slowLoad = [&numLoads]
+    {
+        ++numLoads;
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+        return std::make_shared<const LoadedSample>();
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i)
+        threads.emplace_back ([&, i] { results[static_cast<size_t> (i)] = cache.getOrLoad (makeTestKey ("shared.wav"), slowLoad, neverStop); });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK (numLoads == 1);
+
+    for (const auto& result : results)
+    {
+        REQUIRE (result != nullptr);
+        CHECK (result == results.front());
+    }
+}
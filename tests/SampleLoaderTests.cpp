@@ -0,0 +1,197 @@
+#include <SampleLoader.h>
+#include <SampleRateConverter.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    void writeTestFile (const juce::File& file, int numSamples)
+    {
+        juce::AudioBuffer<float> audio (1, numSamples);
+        for (int i = 0; i < numSamples; ++i)
+            audio.setSample (0, i, 0.5f * std::sin (static_cast<float> (i) * 0.05f));
+
+        juce::WavAudioFormat wav;
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), 44100.0, 1, 16, {}, 0));
+        REQUIRE (writer != nullptr);
+        stream.release(); // Owned by the writer now
+
+        writer->writeFromAudioSampleBuffer (audio, 0, numSamples);
+    }
+}
+
+TEST_CASE ("Sample loader decodes in the background and hands over once", "[sampleloader]")
+{
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile(), 1000);
+
+    SampleLoader loader;
+    CHECK (loader.takeLoaded() == nullptr);
+
+    loader.load (tempFile.getFile());
+    REQUIRE (loader.waitUntilIdle (5000));
+
+    const auto latest = loader.getLatest();
+    REQUIRE (latest != nullptr);
+    CHECK (latest->audio.getNumSamples() == 1000);
+    CHECK (latest->sampleRate == 44100.0);
+    CHECK_FALSE (latest->renderBuffer.empty());
+
+    const auto* taken = loader.takeLoaded();
+    CHECK (taken == latest.get());
+    CHECK (loader.takeLoaded() == nullptr);
+
+    CHECK (loader.retire (taken));
+}
+
+TEST_CASE ("Sample loader skips samples the audio thread never took", "[sampleloader]")
+{
+    juce::TemporaryFile first (".wav");
+    juce::TemporaryFile second (".wav");
+    writeTestFile (first.getFile(), 1000);
+    writeTestFile (second.getFile(), 2000);
+
+    SampleLoader loader;
+
+    loader.load (first.getFile());
+    REQUIRE (loader.waitUntilIdle (5000));
+    loader.load (second.getFile());
+    REQUIRE (loader.waitUntilIdle (5000));
+
+    const auto* taken = loader.takeLoaded();
+    REQUIRE (taken != nullptr);
+    CHECK (taken->audio.getNumSamples() == 2000);
+    CHECK (taken == loader.getLatest().get());
+}
+
+TEST_CASE ("Sample loader keeps the current sample when a file fails to load", "[sampleloader]")
+{
+    juce::TemporaryFile good (".wav");
+    juce::TemporaryFile bad (".wav");
+    writeTestFile (good.getFile(), 1000);
+    REQUIRE (bad.getFile().replaceWithText ("not audio"));
+
+    SampleLoader loader;
+
+    loader.load (good.getFile());
+    REQUIRE (loader.waitUntilIdle (5000));
+    loader.load (bad.getFile());
+    REQUIRE (loader.waitUntilIdle (5000));
+
+    REQUIRE (loader.getLatest() != nullptr);
+    CHECK (loader.getLatest()->file == good.getFile());
+}
+
+TEST_CASE ("Streamed samples read the same as samples decoded into memory", "[sampleloader]")
+{
+    constexpr int numSamples = 300000;
+
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile(), numSamples);
+
+    SampleLoader inMemoryLoader;
+    inMemoryLoader.load (tempFile.getFile());
+
+    SampleLoader streamingLoader;
+    streamingLoader.setStreamingThreshold (1000);
+    streamingLoader.load (tempFile.getFile());
+
+    REQUIRE (inMemoryLoader.waitUntilIdle (5000));
+    REQUIRE (streamingLoader.waitUntilIdle (5000));
+
+    const auto inMemory = inMemoryLoader.getLatest();
+    const auto streamed = streamingLoader.getLatest();
+    REQUIRE (inMemory != nullptr);
+    REQUIRE (streamed != nullptr);
+    CHECK_FALSE (inMemory->isStreamed());
+    REQUIRE (streamed->isStreamed());
+
+    // Only an overview is kept in memory for display
+    CHECK (streamed->renderBuffer.empty());
+    CHECK (streamed->overviewStride > 1);
+    CHECK (streamed->audio.getNumSamples() < numSamples);
+
+    const auto expected = inMemory->getSource();
+    const auto actual = streamed->getSource();
+    REQUIRE (actual.numSamples == expected.numSamples);
+
+    // Including the wrapped guard samples either side
+    bool matches = true;
+    for (int i = -GrainRenderer::guardSamples; i < numSamples + GrainRenderer::guardSamples; ++i)
+        matches = matches && actual.samples[i] == expected.samples[i];
+
+    CHECK (matches);
+}
+
+TEST_CASE ("Sample loader converts render buffers to the target rate", "[sampleloader]")
+{
+    constexpr int numSamples = 300000;
+
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile(), numSamples);
+
+    SampleLoader inMemoryLoader;
+    inMemoryLoader.load (tempFile.getFile());
+    REQUIRE (inMemoryLoader.waitUntilIdle (5000));
+    REQUIRE (inMemoryLoader.getLatest() != nullptr);
+    CHECK (inMemoryLoader.getLatest()->renderSampleRate == 44100.0);
+
+    // A new rate reloads the current file
+    inMemoryLoader.setTargetSampleRate (48000.0);
+    REQUIRE (inMemoryLoader.waitUntilIdle (5000));
+
+    SampleLoader streamingLoader;
+    streamingLoader.setStreamingThreshold (1000);
+    streamingLoader.setTargetSampleRate (48000.0);
+    streamingLoader.load (tempFile.getFile());
+    REQUIRE (streamingLoader.waitUntilIdle (5000));
+
+    const auto inMemory = inMemoryLoader.getLatest();
+    const auto streamed = streamingLoader.getLatest();
+    REQUIRE (inMemory != nullptr);
+    REQUIRE (streamed != nullptr);
+    REQUIRE (streamed->isStreamed());
+
+    // The display keeps the file's own rate
+    CHECK (inMemory->sampleRate == 44100.0);
+    CHECK (inMemory->audio.getNumSamples() == numSamples);
+    CHECK (inMemory->renderSampleRate == 48000.0);
+    CHECK (streamed->renderSampleRate == 48000.0);
+
+    const auto expected = inMemory->getSource();
+    const auto actual = streamed->getSource();
+    CHECK (expected.numSamples == SampleRateConverter (44100.0, 48000.0).getOutputLength (numSamples));
+    REQUIRE (actual.numSamples == expected.numSamples);
+
+    bool matches = true;
+    for (int i = -GrainRenderer::guardSamples; i < expected.numSamples + GrainRenderer::guardSamples; ++i)
+        matches = matches && actual.samples[i] == expected.samples[i];
+
+    CHECK (matches);
+}
+
+TEST_CASE ("Sample loaders share one copy of the same file", "[sampleloader]")
+{
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile(), 1000);
+
+    SampleLoader first;
+    SampleLoader second;
+
+    first.load (tempFile.getFile());
+    REQUIRE (first.waitUntilIdle (5000));
+    second.load (tempFile.getFile());
+    REQUIRE (second.waitUntilIdle (5000));
+
+    REQUIRE (first.getLatest() != nullptr);
+    CHECK (first.getLatest() == second.getLatest());
+
+    // Rewriting the file gives it a new key, so it's decoded again
+    writeTestFile (tempFile.getFile(), 2000);
+    second.load (tempFile.getFile());
+    REQUIRE (second.waitUntilIdle (5000));
+
+    REQUIRE (second.getLatest() != nullptr);
+    CHECK (second.getLatest() != first.getLatest());
+    CHECK (second.getLatest()->audio.getNumSamples() == 2000);
+}
@@ -0,0 +1,76 @@
+#include <SampleRateConverter.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+
+namespace
+{
+    std::vector<float> makeSine (double frequency, double sampleRate, int numSamples)
+    {
+        std::vector<float> sine (static_cast<size_t> (numSamples));
+        for (int i = 0; i < numSamples; ++i)
+            sine[static_cast<size_t> (i)] = static_cast<float> (0.5 * std::sin (juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+        return sine;
+    }
+
+    // Feeds the input in uneven blocks, as the loader's chunks would be
+    std::vector<float> convert (const std::vector<float>& input, double sourceRate, double targetRate)
+    {
+        SampleRateConverter converter (sourceRate, targetRate);
+        std::vector<float> output;
+
+        for (size_t position = 0; position < input.size();)
+        {
+            const auto numSamples = std::min<size_t> (1000 + position % 777, input.size() - position);
+            converter.process (input.data() + position, static_cast<int> (numSamples), output);
+            position += numSamples;
+        }
+
+        converter.finish (output);
+        return output;
+    }
+}
+
+TEST_CASE ("Sample rate conversion keeps a sine's pitch and level", "[samplerate]")
+{
+    constexpr double frequency = 1000.0;
+
+    for (const auto& [sourceRate, targetRate] : { std::pair { 44100.0, 48000.0 }, std::pair { 48000.0, 44100.0 } })
+    {
+        const auto output = convert (makeSine (frequency, sourceRate, 44100), sourceRate, targetRate);
+        const auto expected = makeSine (frequency, targetRate, static_cast<int> (output.size()));
+
+        SampleRateConverter converter (sourceRate, targetRate);
+        REQUIRE (static_cast<juce::int64> (output.size()) == converter.getOutputLength (44100));
+
+        // Away from the edges, where the file starts and ends abruptly
+        float maxError = 0.0f;
+        for (size_t i = 200; i < output.size() - 200; ++i)
+            maxError = std::max (maxError, std::abs (output[i] - expected[i]));
+
+        CHECK (maxError < 1.0e-3f);
+    }
+}
+
+TEST_CASE ("Sample rate conversion removes content above the new Nyquist frequency", "[samplerate]")
+{
+    // 23 kHz would alias to 21.1 kHz at 44.1 kHz
+    const auto output = convert (makeSine (23000.0, 48000.0, 48000), 48000.0, 44100.0);
+
+    float peak = 0.0f;
+    for (size_t i = 200; i < output.size() - 200; ++i)
+        peak = std::max (peak, std::abs (output[i]));
+
+    CHECK (peak < 0.01f);
+}
+
+TEST_CASE ("Sample rate conversion at the same rate passes samples through", "[samplerate]")
+{
+    const auto input = makeSine (440.0, 44100.0, 5000);
+    const auto output = convert (input, 44100.0, 44100.0);
+
+    REQUIRE (output.size() == input.size());
+
+    for (size_t i = 0; i < input.size(); ++i)
+        REQUIRE (output[i] == Catch::Approx (input[i]).margin (1.0e-6));
+}
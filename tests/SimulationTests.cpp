@@ -0,0 +1,214 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <thread>
+
+namespace
+{
+    // Particle positions after playing a chord for numBlocks blocks, optionally stalling between blocks
+    std::vector<juce::Point<float>> simulate (int numBlocks, bool stallBetweenBlocks,
+                                              const std::vector<int>& chord = { 48, 55, 64, 71 },
+                                              bool addSecondSpawnPoint = false)
+    {
+        constexpr int blockSize = 256;
+
+        PluginProcessor plugin;
+        if (addSecondSpawnPoint)
+            plugin.addSpawnPoint ({ 300.0f, 100.0f }, juce::MathConstants<float>::pi);
+
+        plugin.prepareToPlay (44100.0, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+        for (int note : chord)
+            midi.addEvent (juce::MidiMessage::noteOn (1, note, 0.8f), 0);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            plugin.processBlock (buffer, midi);
+            midi.clear();
+
+            if (stallBetweenBlocks && block % 10 == 0)
+                std::this_thread::sleep_for (std::chrono::milliseconds (3));
+        }
+
+        std::vector<juce::Point<float>> positions;
+        for (auto* particle : *plugin.getParticles())
+            positions.push_back (particle->getPosition());
+
+        plugin.releaseResources();
+        return positions;
+    }
+}
+
+TEST_CASE ("Simulation follows the sample clock, not wall time", "[simulation]")
+{
+    const auto offline = simulate (200, false);
+    const auto stalled = simulate (200, true);
+
+    REQUIRE (offline.size() == 4);
+    CHECK (offline == stalled);
+}
+
+TEST_CASE ("Every render starts notes from the same spawn points", "[simulation]")
+{
+    // An odd chord over two spawn points, so a round-robin carried over from the
+    // first render would start the second one on the other point
+    const std::vector<int> chord { 48, 55, 64 };
+    const auto first = simulate (50, false, chord, true);
+    const auto second = simulate (50, false, chord, true);
+
+    REQUIRE (first.size() == 3);
+    CHECK (first == second);
+}
+
+namespace
+{
+    struct Render
+    {
+        std::vector<juce::Point<float>> positions;
+        std::vector<float> audio;   // Left channel
+    };
+
+    void writeTestFile (const juce::File& file)
+    {
+        juce::AudioBuffer<float> audio (1, 44100);
+        for (int i = 0; i < audio.getNumSamples(); ++i)
+            audio.setSample (0, i, 0.5f * std::sin (juce::MathConstants<float>::twoPi * 220.0f * static_cast<float> (i) / 44100.0f));
+
+        juce::WavAudioFormat wav;
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), 44100.0, 1, 16, {}, 0));
+        REQUIRE (writer != nullptr);
+        stream.release(); // Owned by the writer now
+
+        writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    // The same chord and release, played in blocks of blockSize
+    Render render (const juce::File& file, int blockSize, int numSamples)
+    {
+        PluginProcessor plugin;
+        plugin.loadAudioFile (file);
+        REQUIRE (plugin.waitForAudioFile());
+        plugin.prepareToPlay (44100.0, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        Render result;
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            juce::MidiBuffer midi;
+
+            if (position == 0)
+                for (int note : { 48, 55, 64, 71 })
+                    midi.addEvent (juce::MidiMessage::noteOn (1, note, 0.8f), 0);
+
+            // Released at a time every block size lands on
+            if (position == numSamples / 2)
+                for (int note : { 48, 55, 64, 71 })
+                    midi.addEvent (juce::MidiMessage::noteOff (1, note), 0);
+
+            plugin.processBlock (buffer, midi);
+            result.audio.insert (result.audio.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+        }
+
+        for (auto* particle : *plugin.getParticles())
+            result.positions.push_back (particle->getPosition());
+
+        plugin.releaseResources();
+        return result;
+    }
+}
+
+TEST_CASE ("Sound doesn't depend on the host block size", "[simulation]")
+{
+    constexpr int numSamples = 2048 * 64;   // About three seconds
+
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile());
+
+    const auto reference = render (tempFile.getFile(), 64, numSamples);
+    REQUIRE_FALSE (reference.positions.empty());
+
+    for (int blockSize : { 512, 2048 })
+    {
+        const auto other = render (tempFile.getFile(), blockSize, numSamples);
+
+        // Physics ticks on the sample clock, so the particles end up in the same places
+        CHECK (other.positions == reference.positions);
+        REQUIRE (other.audio.size() == reference.audio.size());
+
+        // The grains are the same; only the gain compensation, which follows the number of
+        // overlapping grains at block boundaries, may differ slightly
+        double cross = 0.0, referenceEnergy = 0.0, otherEnergy = 0.0;
+        for (size_t i = 0; i < reference.audio.size(); ++i)
+        {
+            cross += static_cast<double> (reference.audio[i]) * other.audio[i];
+            referenceEnergy += static_cast<double> (reference.audio[i]) * reference.audio[i];
+            otherEnergy += static_cast<double> (other.audio[i]) * other.audio[i];
+        }
+
+        REQUIRE (referenceEnergy > 0.0);
+        CHECK (cross / std::sqrt (referenceEnergy * otherEnergy) > 0.99);
+        CHECK (std::abs (juce::Decibels::gainToDecibels (std::sqrt (otherEnergy / referenceEnergy))) < 0.5);
+    }
+}
+
+namespace
+{
+    // Level of the left channel over the last half of numSamples, with notes played at the
+    // start from the single default spawn point, so any two of them meet straight away
+    double renderMergedLevel (const juce::File& file, const std::vector<int>& notes, int numSamples)
+    {
+        constexpr int blockSize = 512;
+
+        PluginProcessor plugin;
+        plugin.loadAudioFile (file);
+        REQUIRE (plugin.waitForAudioFile());
+
+        auto* collisions = plugin.getAPVTS().getParameter ("collisions");
+        collisions->setValueNotifyingHost (collisions->convertTo0to1 (2.0f));   // Merge
+        plugin.getAPVTS().getParameter ("release")->setValueNotifyingHost (0.0f);
+        plugin.prepareToPlay (44100.0, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        double energy = 0.0;
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            juce::MidiBuffer midi;
+
+            if (position == 0)
+                for (int note : notes)
+                    midi.addEvent (juce::MidiMessage::noteOn (1, note, 0.8f), 0);
+
+            plugin.processBlock (buffer, midi);
+
+            // By then the absorbed particle has been released and removed
+            if (position >= numSamples / 2)
+                for (int i = 0; i < blockSize; ++i)
+                    energy += static_cast<double> (buffer.getSample (0, i)) * buffer.getSample (0, i);
+        }
+
+        plugin.releaseResources();
+        return energy;
+    }
+}
+
+TEST_CASE ("A merged particle renders louder than either input", "[simulation]")
+{
+    constexpr int numSamples = 44100 * 2;
+
+    juce::TemporaryFile tempFile (".wav");
+    writeTestFile (tempFile.getFile());
+
+    const auto first = renderMergedLevel (tempFile.getFile(), { 60 }, numSamples);
+    const auto second = renderMergedLevel (tempFile.getFile(), { 67 }, numSamples);
+    const auto merged = renderMergedLevel (tempFile.getFile(), { 60, 67 }, numSamples);
+
+    REQUIRE (first > 0.0);
+    REQUIRE (second > 0.0);
+    CHECK (merged > first);
+    CHECK (merged > second);
+}
@@ -0,0 +1,47 @@
+#include <SpatialHash.h>
+#include <catch2/catch_test_macros.hpp>
+#include <set>
+
+TEST_CASE ("Spatial hash finds every pair within the cell size", "[physics]")
+{
+    constexpr int numBodies = 500;
+    constexpr float radius = 12.0f;
+    const juce::Rectangle<float> bounds (0.0f, 0.0f, 400.0f, 300.0f);
+
+    juce::Random random (3);
+    std::vector<float> x, y, weight;
+
+    for (int i = 0; i < numBodies; ++i)
+    {
+        // A few stray bodies just outside the bounds, as between a step and the wrap
+        x.push_back (random.nextFloat() * 410.0f - 5.0f);
+        y.push_back (random.nextFloat() * 310.0f - 5.0f);
+        weight.push_back (i % 10 == 0 ? 0.0f : 1.0f);
+    }
+
+    SpatialHash hash;
+    hash.reserve (numBodies);
+    hash.build (x.data(), y.data(), weight.data(), numBodies, bounds, radius);
+
+    std::set<std::pair<int, int>> found;
+    hash.forEachNearbyPair ([&] (int i, int j)
+    {
+        // Each pair comes up once
+        CHECK (found.insert ({ std::min (i, j), std::max (i, j) }).second);
+    });
+
+    for (int i = 0; i < numBodies; ++i)
+    {
+        for (int j = i + 1; j < numBodies; ++j)
+        {
+            const float dx = x[(size_t) j] - x[(size_t) i];
+            const float dy = y[(size_t) j] - y[(size_t) i];
+
+            if (dx * dx + dy * dy > radius * radius)
+                continue;
+
+            const bool weighted = weight[(size_t) i] > 0.0f && weight[(size_t) j] > 0.0f;
+            CHECK (found.count ({ i, j }) == (weighted ? 1u : 0u));
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#include <TripleBuffer.h>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+namespace
+{
+    // Every field holds the same value, so a torn read shows up as a mismatch
+    struct Frame
+    {
+        std::array<int, 64> values {};
+    };
+}
+
+TEST_CASE ("Triple buffer reader sees the latest published value", "[triplebuffer]")
+{
+    TripleBuffer<int> buffer;
+    buffer.forEachBuffer ([] (int& value) { value = -1; });
+
+    CHECK (buffer.read() == -1);
+
+    buffer.getWriteBuffer() = 1;
+    buffer.publish();
+    CHECK (buffer.read() == 1);
+
+    // Nothing new: the reader keeps its value
+    CHECK (buffer.read() == 1);
+
+    // Several publishes between reads: the latest wins
+    for (int value = 2; value <= 5; ++value)
+    {
+        buffer.getWriteBuffer() = value;
+        buffer.publish();
+    }
+
+    CHECK (buffer.read() == 5);
+    CHECK (buffer.read() == 5);
+}
+
+TEST_CASE ("Triple buffer hands over whole values in order across threads", "[triplebuffer]")
+{
+    constexpr int numFrames = 200000;
+
+    TripleBuffer<Frame> buffer;
+
+    std::thread writer ([&buffer]
+    {
+        for (int frame = 1; frame <= numFrames; ++frame)
+        {
+            buffer.getWriteBuffer().values.fill (frame);
+            buffer.publish();
+        }
+    });
+
+    int last = 0;
+    bool torn = false;
+    bool wentBackwards = false;
+
+    while (last < numFrames)
+    {
+        const auto& frame = buffer.read();
+        const int value = frame.values.front();
+
+        for (int v : frame.values)
+            torn = torn || v != value;
+
+        wentBackwards = wentBackwards || value < last;
+        last = value;
+    }
+
+    writer.join();
+
+    CHECK_FALSE (torn);
+    CHECK_FALSE (wentBackwards);
+    CHECK (last == numFrames);
+}